@@ -0,0 +1,66 @@
+/**
+ * @file benchmark/bench_parse.cpp
+ * @brief Timing of serial against parallel load() over a range of file sizes
+ * @details Build with -DMJSON_BUILD_TEST=ON -DMJSON_BUILD_RELEASE=ON and run `mjson_bench_parse [threads]`,
+ * 0 or nothing for one thread per core. Each file holds an array of records, the common shape of large
+ * parameter files. The smallest size from which the parallel load wins on a machine is the `min_size`
+ * to pass to ParaManager::set_parallel() there.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include "mjson.hpp"
+
+template<class F> double best_ms(F&& run, int rounds = 5) {
+    double _best = 1e300;
+    for(int i = 0; i < rounds; i++) {
+        auto _start = std::chrono::steady_clock::now();
+        run();
+        _best = std::min(_best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count());
+    }
+    return _best;
+}
+
+//! {"records": [{"id": 0, "name": "...", "position": [x, y, z], "enabled": true}, ...]} of about `size` bytes
+static std::string make_records(std::size_t size) {
+    std::mt19937_64 _rng(42);
+    std::normal_distribution<double> _normal(0.0, 100.0);
+    std::string _text = "{\"records\": [";
+    for(std::size_t i = 0; _text.size() < size; i++) {
+        if(i != 0) _text += ", ";
+        _text += "{\"id\": " + std::to_string(i) + ", \"name\": \"record " + std::to_string(i) + "\", \"position\": [";
+        _text += std::to_string(_normal(_rng)) + ", " + std::to_string(_normal(_rng)) + ", " + std::to_string(_normal(_rng));
+        _text += "], \"enabled\": " + std::string(i % 2 ? "true" : "false") + "}";
+    }
+    _text += "]}";
+    return _text;
+}
+
+int main(int argc, char** argv) {
+    std::size_t _threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 0;
+    if(_threads == 0) _threads = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%u core(s), parallel load on %zu thread(s)\n", std::thread::hardware_concurrency(), _threads);
+
+    const std::string _path = "bench_parse.json";
+    for(std::size_t _size : {std::size_t(256) << 10, std::size_t(1) << 20, std::size_t(4) << 20, std::size_t(16) << 20, std::size_t(64) << 20}) {
+        {
+            std::FILE* fp = std::fopen(_path.c_str(), "wb");
+            if(fp == nullptr) return 1;
+            std::string _text = make_records(_size);
+            std::fwrite(_text.data(), 1, _text.size(), fp);
+            std::fclose(fp);
+        }
+        param::ParaManager _serial{};
+        param::ParaManager _parallel{};
+        _parallel.set_parallel(_threads, 0);
+        double _serial_ms = best_ms([&]() { _serial.load(_path); });
+        double _parallel_ms = best_ms([&]() { _parallel.load(_path); });
+        std::printf("%6zu KB: serial %8.1f ms, parallel %8.1f ms, speedup %.2f\n", _size >> 10, _serial_ms, _parallel_ms, _serial_ms / _parallel_ms);
+    }
+    std::remove(_path.c_str());
+    return 0;
+}
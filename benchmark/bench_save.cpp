@@ -0,0 +1,91 @@
+/**
+ * @file benchmark/bench_save.cpp
+ * @brief Timing of double formatting and of saving matrices written by ParaManager::set
+ * @details Build with -DMJSON_BUILD_TEST=ON -DMJSON_BUILD_RELEASE=ON and run `mjson_bench_save [rows cols]`.
+ * Grisu2 and Schubfach are timed side by side on the same values, then a rows x cols matrix of
+ * doubles is set() into a document and saved compact and pretty. save() formats doubles with
+ * Schubfach here and with Grisu2 in `mjson_bench_save_grisu2`, the same source built with
+ * RAPIDJSON_DTOA_GRISU2, so running both compares the saves.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "mjson.hpp"
+
+template<class F> double best_ms(F&& run, int rounds = 5) {
+    double _best = 1e300;
+    for(int i = 0; i < rounds; i++) {
+        auto _start = std::chrono::steady_clock::now();
+        run();
+        _best = std::min(_best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count());
+    }
+    return _best;
+}
+
+//! printed at the end so that the timed loops are not optimized away
+static std::size_t g_checksum = 0;
+
+//! digit generation only, the shared Prettify step is left out
+template<class D> double time_digits(const std::vector<double>& values, D&& digits) {
+    char _buffer[32];
+    std::size_t _sum = 0;
+    double _ms = best_ms([&]() {
+        for(double value : values) {
+            int _length = 0, _K = 0;
+            digits(value, _buffer, &_length, &_K);
+            _sum += static_cast<std::size_t>(_length + _K);
+        }
+    });
+    g_checksum += _sum;
+    return _ms;
+}
+
+void bench_dtoa(const char* name, const std::vector<double>& values) {
+    double _grisu = time_digits(values, rapidjson::internal::Grisu2);
+    double _schubfach = time_digits(values, rapidjson::internal::Schubfach);
+    std::printf("dtoa %-24s %zu values: Grisu2 %8.1f ms, Schubfach %8.1f ms\n", name, values.size(), _grisu, _schubfach);
+}
+
+int main(int argc, char** argv) {
+    std::size_t _rows = argc > 2 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    std::size_t _cols = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+
+    std::mt19937_64 _rng(42);
+    std::normal_distribution<double> _normal(0.0, 100.0);
+    std::vector<double> _values(2000000), _decimals(2000000);
+    for(auto& value : _values) value = std::abs(_normal(_rng)) + 1e-3;
+    for(std::size_t i = 0; i < _decimals.size(); i++) _decimals[i] = static_cast<double>(i % 100000 + 1) / 8;
+    bench_dtoa("normal(0,100)", _values);
+    bench_dtoa("short decimals (k/8)", _decimals);
+
+    std::vector<std::vector<double>> _matrix(_rows, std::vector<double>(_cols));
+    for(auto& row : _matrix) {
+        for(auto& item : row) item = _normal(_rng);
+    }
+    const std::string _path = "bench_save.json";
+    {
+        std::FILE* fp = std::fopen(_path.c_str(), "wb");
+        if(fp == nullptr) return 1;
+        std::fputs("{}", fp);
+        std::fclose(fp);
+    }
+    param::ParaManager _manager{};
+    _manager.load(_path);
+    double _set = best_ms([&]() { _manager.erase("/matrix"); _manager.set("/matrix", _matrix); });
+    // set() marks the document dirty, so every round writes the file
+    double _compact = best_ms([&]() { _manager.set("/round", 0); _manager.save(_path, true); });
+    double _pretty = best_ms([&]() { _manager.set("/round", 0); _manager.save(_path, false); });
+#ifdef RAPIDJSON_DTOA_GRISU2
+    const char* _dtoa = "Grisu2";
+#else
+    const char* _dtoa = "Schubfach";
+#endif
+    std::printf("%zux%zu matrix, save() with %s: set %.1f ms, compact save %.1f ms, pretty save %.1f ms\n", _rows, _cols, _dtoa, _set, _compact, _pretty);
+    std::remove(_path.c_str());
+    std::printf("(checksum %zu)\n", g_checksum);
+    return 0;
+}
@@ -42,6 +42,9 @@ int main() {
     std::cout << pm.get<double>("/basic/float") << std::endl;
     std::cout << pm.get<std::string>("/basic/string") << std::endl;
 
+    auto key = pm.compile("/basic/float");
+    std::cout << pm.get<double>(key) << std::endl;
+
     print_array(pm.get<std::list<int>>("/advanced/list"), ", ");
     print_array(pm.get<std::vector<double>>("/advanced/vector"), ", ");
     print_array(pm.get<std::vector<std::complex<double>>>("/advanced/complex_vector"), ", ");
@@ -70,10 +73,23 @@ int main() {
     auto mat4d = pm.get<Mat4D<double>>("/advanced/matrix4d");
     print_matrix(mat4d, ", ");
 
+    std::cout << "------ 4D NDArray ------" << std::endl;
+    auto nd4d = pm.get<param::NDArray<double>>("/advanced/matrix4d");
+    print_array(nd4d.shape(), ", ");
+    std::cout << nd4d(1, 1, 1, 2) << std::endl;
+
     std::cout << "------ 2D Matrix Complex------" << std::endl;
     auto mat2cd = pm.get<std::vector<std::vector<std::complex<double>>>>("/advanced/complex_matrix");
     print_matrix(mat2cd, ", ");
 
+#ifdef MJSON_CPP_USE_EIGEN
+    std::cout << "------ Eigen Matrix ------" << std::endl;
+    auto eigen2d = pm.get<Eigen::MatrixXd>("/advanced/matrix2d");
+    std::cout << eigen2d << std::endl;
+    pm.set("/test/eigen_matrix", Eigen::Matrix3d(Eigen::Matrix3d::Identity()));
+    std::cout << pm.get<Eigen::Matrix3cd>("/test/eigen_matrix") << std::endl;
+#endif //MJSON_CPP_USE_EIGEN
+
     pm.save("save.json");
 
     return 0;
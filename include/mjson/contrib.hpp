@@ -12,6 +12,9 @@
 // CMake Compile Configuration
 #include "config.h"
 
+// Mathematical JSON
+#include "mjson.hpp"
+
 #ifdef MJSON_CPP_USE_EIGEN
 // Eigen Library
 #include <Eigen/Dense>
@@ -22,9 +25,78 @@ namespace param {
 
 #ifdef MJSON_CPP_USE_EIGEN
         template<typename T> struct is_eigen : std::is_base_of<Eigen::EigenBase<T>, T> {};
+
+        //! Eigen::Matrix and Eigen::Array, which own their storage and can be resized
+        template<typename T> struct is_eigen_plain : std::is_base_of<Eigen::PlainObjectBase<T>, T> {};
 #endif //MJSON_CPP_USE_EIGEN
 
     }
+
+#ifdef MJSON_CPP_USE_EIGEN
+    /**
+     * @brief Eigen dense matrices as nested row arrays, vectors as flat arrays.
+     * @details get() takes the shape from the json array, checks it against compile-time dimensions
+     * and fills the coefficients in place. A flat array is read as a column, or as a row for row vectors.
+     * Complex coefficients may be [re, im] pairs, so a complex matrix is nested only if its rows hold pairs.
+     */
+    template<typename T> struct converter<T, std::enable_if_t<contrib::is_eigen_plain<T>::value>> : std::true_type {
+        using Scalar = typename T::Scalar;
+        using Index = Eigen::Index;
+
+        static constexpr bool is_vector = T::RowsAtCompileTime == 1 || T::ColsAtCompileTime == 1;
+
+        static T get(ParaManager& manager, rapidjson::Value* value_ptr, const T& default_value) {
+            if(value_ptr == nullptr || !value_ptr->IsArray()) return default_value;
+            // [re, im] pairs of a complex vector are coefficients, not rows
+            bool _nested = !value_ptr->Empty() && (*value_ptr)[0].IsArray() && !ParaManager::is_pair_element_<Scalar>((*value_ptr)[0]);
+            Index _rows = static_cast<Index>(value_ptr->Size());
+            Index _cols = _nested ? static_cast<Index>((*value_ptr)[0].Size()) : 1;
+            if(!_nested && T::RowsAtCompileTime == 1) std::swap(_rows, _cols);
+            if((T::RowsAtCompileTime != Eigen::Dynamic && T::RowsAtCompileTime != _rows) ||
+               (T::ColsAtCompileTime != Eigen::Dynamic && T::ColsAtCompileTime != _cols)) return default_value;
+
+            T value{};
+            value.resize(_rows, _cols);
+            if(!_nested) {
+                Index _index = 0;
+                for(auto& item : value_ptr->GetArray()) value(_index++) = manager.get_<Scalar>(&item);
+                return value;
+            }
+            Index _row = 0;
+            for(auto& row : value_ptr->GetArray()) {
+                if(!row.IsArray() || static_cast<Index>(row.Size()) != _cols) return default_value;
+                Index _col = 0;
+                for(auto& item : row.GetArray()) value(_row, _col++) = manager.get_<Scalar>(&item);
+                _row++;
+            }
+            return value;
+        }
+
+        static void set(ParaManager& manager, rapidjson::Value* value_ptr, const T& value) {
+            auto& _allocator = manager.document_.GetAllocator();
+            value_ptr->SetArray();
+            if(is_vector) {
+                value_ptr->Reserve(static_cast<rapidjson::SizeType>(value.size()), _allocator);
+                for(Index i = 0; i < value.size(); i++) {
+                    value_ptr->PushBack(rapidjson::Value(), _allocator);
+                    manager.set_<Scalar>(&(*value_ptr)[static_cast<rapidjson::SizeType>(i)], value(i));
+                }
+                return;
+            }
+            value_ptr->Reserve(static_cast<rapidjson::SizeType>(value.rows()), _allocator);
+            for(Index i = 0; i < value.rows(); i++) {
+                rapidjson::Value _row(rapidjson::kArrayType);
+                _row.Reserve(static_cast<rapidjson::SizeType>(value.cols()), _allocator);
+                for(Index j = 0; j < value.cols(); j++) {
+                    _row.PushBack(rapidjson::Value(), _allocator);
+                    manager.set_<Scalar>(&_row[static_cast<rapidjson::SizeType>(j)], value(i, j));
+                }
+                value_ptr->PushBack(_row, _allocator);
+            }
+        }
+    };
+#endif //MJSON_CPP_USE_EIGEN
+
 }
 
 #endif //MJSON_CPP_CONTRIB
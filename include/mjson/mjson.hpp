@@ -15,8 +15,33 @@
 #include <complex>
 #include <string>
 #include <vector>
-#include <functional>
+#include <array>
+#include <utility>
 #include <algorithm>
+#include <numeric>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <limits>
+#include <set>
+#include <unordered_map>
+#include <future>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 
 // RapidJSON Library
 #include <rapidjson/document.h>
@@ -24,139 +49,2822 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/istreamwrapper.h>
 #include <rapidjson/ostreamwrapper.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/filewritestream.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/prettywriter.h>
+#include <rapidjson/internal/dtoa.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+// POSIX memory mapping for .npy sidecars and fsync for save
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define MJSON_CPP_POSIX
+#endif
+
+#ifdef __linux__
+// Linux inotify for ConcurrentParaManager::watch
+#include <sys/inotify.h>
+#include <poll.h>
+#endif //__linux__
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+// SSSE3 base64 codec, compiled per function and chosen at run time
+#include <tmmintrin.h>
+#define MJSON_CPP_BASE64_SSSE3
+#endif
+
+namespace param {
+
+    /**
+     * @brief N-dimensional array with one contiguous row-major buffer.
+     * @details Strides are counted in elements, so data() can be handed to BLAS/LAPACK as is.
+     * ParaManager reads it from nested json arrays of equal lengths and writes it back the same way.
+     */
+    template<typename T> class NDArray {
+        static_assert(!std::is_same<T, bool>::value, "NDArray<bool> has no contiguous storage");
+
+    public:
+        using value_type = T;
+        using iterator = typename std::vector<T>::iterator;
+        using const_iterator = typename std::vector<T>::const_iterator;
+
+        NDArray() = default;
+        explicit NDArray(std::vector<std::size_t> shape, const T& value = T()) { resize(std::move(shape), value); }
+
+        void resize(std::vector<std::size_t> shape, const T& value = T()) {
+            shape_ = std::move(shape);
+            update_strides_();
+            data_.assign(count_(shape_), value);
+        }
+
+        //! change the shape keeping the data, the number of elements must not change
+        bool reshape(std::vector<std::size_t> shape) {
+            if(count_(shape) != data_.size()) return false;
+            shape_ = std::move(shape);
+            update_strides_();
+            return true;
+        }
+
+        const std::vector<std::size_t>& shape() const { return shape_; }
+        const std::vector<std::size_t>& strides() const { return strides_; }
+        std::size_t ndim() const { return shape_.size(); }
+        std::size_t size() const { return data_.size(); }
+        bool empty() const { return data_.empty(); }
+
+        T* data() { return data_.data(); }
+        const T* data() const { return data_.data(); }
+
+        T& operator [] (std::size_t index) { return data_[index]; }
+        const T& operator [] (std::size_t index) const { return data_[index]; }
+
+        template<typename... I> T& operator () (I... index) { return data_[offset_(index...)]; }
+        template<typename... I> const T& operator () (I... index) const { return data_[offset_(index...)]; }
+
+        iterator begin() { return data_.begin(); }
+        iterator end() { return data_.end(); }
+        const_iterator begin() const { return data_.begin(); }
+        const_iterator end() const { return data_.end(); }
+
+        bool operator == (const NDArray& other) const { return shape_ == other.shape_ && data_ == other.data_; }
+        bool operator != (const NDArray& other) const { return !(*this == other); }
+
+    private:
+        static std::size_t count_(const std::vector<std::size_t>& shape) {
+            std::size_t n = 1;
+            for(auto dim : shape) n *= dim;
+            return n;
+        }
+
+        void update_strides_() {
+            strides_.assign(shape_.size(), 1);
+            for(std::size_t i = shape_.size(); i > 1; i--) strides_[i - 2] = strides_[i - 1] * shape_[i - 1];
+        }
+
+        template<typename... I> std::size_t offset_(I... index) const {
+            assert(sizeof...(I) == shape_.size());
+            const std::size_t _index[] = {0, static_cast<std::size_t>(index)...};
+            std::size_t _offset = 0;
+            for(std::size_t i = 0; i < sizeof...(I); i++) _offset += _index[i + 1] * strides_[i];
+            return _offset;
+        }
+
+        std::vector<std::size_t> shape_;
+        std::vector<std::size_t> strides_;
+        std::vector<T> data_;
+    };
+
+}
+
+namespace param {
+    namespace utils {
+
+    template<typename T> struct is_bool : std::is_same<T, bool> {};
+
+    template<typename T> struct is_integral : std::integral_constant<bool, std::is_integral<T>::value && !is_bool<T>::value> {};
+
+    template<typename T> using is_floating = std::is_floating_point<T>;
+
+    template<typename T> struct is_real : std::integral_constant<bool, is_integral<T>::value || is_floating <T>::value> {};
+
+    template<typename T> struct is_complex : std::false_type {};
+    template<typename T> struct is_complex<std::complex<T>> : std::true_type {};
+
+    template<typename T> struct is_c_string : std::integral_constant<bool, std::is_same<char const *, std::decay_t<T>>::value || std::is_same<char *, std::decay_t<T>>::value> {};
+
+    template<typename T> struct is_cpp_string : std::false_type {};
+    template<typename charT, typename traits, typename Alloc> struct is_cpp_string<std::basic_string<charT, traits, Alloc>> : std::true_type {};
+
+    template<typename T> struct is_string_view : std::false_type {};
+#if __cplusplus >= 201703L
+    template<typename charT, typename traits> struct is_string_view<std::basic_string_view<charT, traits>> : std::true_type {};
+#endif
+
+    template<typename T> struct is_string : std::integral_constant<bool, is_c_string<T>::value || is_cpp_string<T>::value || is_string_view<T>::value> {};
+
+    template<typename T> struct is_sequence : std::false_type {};
+    template<template<typename, typename> class C, typename T, typename Alloc> struct is_sequence<C<T, Alloc>> : std::true_type {};
+
+    template<typename T> struct is_array : std::integral_constant<bool, is_sequence<T>::value && !is_string<T>::value> {};
+
+    //! std::array and C arrays whose extent is checked against the json array
+    template<typename T> struct is_fixed_sequence : std::false_type {};
+    template<typename T, std::size_t N> struct is_fixed_sequence<std::array<T, N>> : std::true_type {};
+    template<typename T, std::size_t N> struct is_fixed_sequence<T[N]> : std::true_type {};
+
+    template<typename T> struct is_fixed_array : std::integral_constant<bool, is_fixed_sequence<T>::value && !is_string<T>::value> {};
+
+    //! results pointing into document memory, including arrays of them
+    template<typename T, typename = void> struct is_view : std::integral_constant<bool, std::is_same<T, const char*>::value || is_string_view<T>::value> {};
+    template<typename T> struct is_view<T, std::enable_if_t<is_array<T>::value>> : is_view<typename T::value_type> {};
+
+    template<typename T> struct is_ndarray : std::false_type {};
+    template<typename T> struct is_ndarray<NDArray<T>> : std::true_type {};
+
+    template<typename T> struct fixed_extent;
+    template<typename T, std::size_t N> struct fixed_extent<std::array<T, N>> : std::integral_constant<std::size_t, N> { using value_type = T; };
+    template<typename T, std::size_t N> struct fixed_extent<T[N]> : std::integral_constant<std::size_t, N> { using value_type = T; };
+
+    template<typename T, typename = void> struct has_reserve : std::false_type {};
+    template<typename T> struct has_reserve<T, decltype(std::declval<T&>().reserve(std::size_t()), void())> : std::true_type {};
+
+    template<class T, std::enable_if_t<has_reserve<T>::value, int> = 0> void reserve(T& container, std::size_t n) { container.reserve(n); }
+    template<class T, std::enable_if_t<!has_reserve<T>::value, int> = 0> void reserve(T& , std::size_t ) {}
+
+    //! shortest round-trip text of a real number, integral values without trailing ".0"
+    inline char* format_real(double value, char* buffer) {
+        if(std::isnan(value)) { std::memcpy(buffer, "nan", 3); return buffer + 3; }
+        if(std::isinf(value)) {
+            if(value < 0) *buffer++ = '-';
+            std::memcpy(buffer, "inf", 3); return buffer + 3;
+        }
+        char* end = rapidjson::internal::dtoa(value, buffer);
+        if(end - buffer > 2 && end[-2] == '.' && end[-1] == '0') end -= 2;
+        return end;
+    }
+
+    //! write complex number as "(re,im)", buffer requires at least 64 chars
+    template<typename T> std::size_t format_complex(const std::complex<T>& value, char* buffer) {
+        char* p = buffer;
+        *p++ = '(';
+        p = format_real(static_cast<double>(value.real()), p);
+        *p++ = ',';
+        p = format_real(static_cast<double>(value.imag()), p);
+        *p++ = ')';
+        return static_cast<std::size_t>(p - buffer);
+    }
+
+    //! read complex number in the forms accepted by std::complex operator>>: "re", "(re)" or "(re,im)"
+    template<typename T> bool parse_complex(const char* str, std::complex<T>& value) {
+        auto skip = [](const char* p) { while(*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++; return p; };
+        char* end = nullptr;
+        const char* p = skip(str);
+        if(*p != '(') {
+            double re = std::strtod(p, &end);
+            if(end == p) return false;
+            value = std::complex<T>(static_cast<T>(re), T());
+            return true;
+        }
+        p = skip(p + 1);
+        double re = std::strtod(p, &end);
+        if(end == p) return false;
+        p = skip(end);
+        double im = 0.0;
+        if(*p == ',') {
+            p = skip(p + 1);
+            im = std::strtod(p, &end);
+            if(end == p) return false;
+            p = skip(end);
+        }
+        if(*p != ')') return false;
+        value = std::complex<T>(static_cast<T>(re), static_cast<T>(im));
+        return true;
+    }
+
+    //! number of nested array levels, e.g. 2 for vector<vector<double>>
+    template<typename T, typename = void> struct rank : std::integral_constant<std::size_t, 0> {};
+    template<typename T> struct rank<T, std::enable_if_t<is_array<T>::value>> : std::integral_constant<std::size_t, 1 + rank<typename T::value_type>::value> {};
+
+    //! innermost element type of nested arrays
+    template<typename T, typename = void> struct scalar_of { using type = T; };
+    template<typename T> struct scalar_of<T, std::enable_if_t<is_array<T>::value>> : scalar_of<typename T::value_type> {};
+    template<typename T> struct scalar_of<NDArray<T>> { using type = T; };
+    template<typename T> using scalar_of_t = typename scalar_of<T>::type;
+
+    //! little-endian storage type and numpy dtype of a scalar in .npy sidecars
+    template<typename T, typename = void> struct npy_storage : std::false_type {};
+    template<typename T> struct npy_storage<T, std::enable_if_t<is_floating<T>::value>> : std::true_type {
+        using type = std::conditional_t<sizeof(T) == 4, float, double>;
+        static const char* dtype() { return sizeof(T) == 4 ? "f4" : "f8"; }
+    };
+    template<typename T> struct npy_storage<T, std::enable_if_t<is_integral<T>::value>> : std::true_type {
+        static constexpr bool narrow = sizeof(T) < 4 || (sizeof(T) == 4 && std::is_signed<T>::value);
+        using type = std::conditional_t<narrow, std::int32_t, std::int64_t>;
+        static const char* dtype() { return narrow ? "i4" : "i8"; }
+    };
+    template<typename T> struct npy_storage<std::complex<T>, std::enable_if_t<is_floating<T>::value>> : std::true_type {
+        using type = std::complex<typename npy_storage<T>::type>;
+        static const char* dtype() { return sizeof(T) == 4 ? "c8" : "c16"; }
+    };
+
+    //! containers eligible for .npy sidecars and base64 typed arrays
+    template<typename T> struct is_typed_array : std::integral_constant<bool, (is_array<T>::value || is_ndarray<T>::value) && npy_storage<scalar_of_t<T>>::value> {};
+
+    //! whether a decoded shape fits the nesting of T, NDArray takes any rank
+    template<typename T> bool rank_matches(std::size_t ndim) { return is_ndarray<T>::value || ndim == rank<T>::value; }
+
+    //! complex data never narrows into a real container
+    template<typename T, typename S> struct npy_convertible : std::integral_constant<bool, is_complex<T>::value || !is_complex<S>::value> {};
+
+    //! read-only view of a whole file, memory-mapped where available
+    class mapped_file {
+    public:
+        explicit mapped_file(const std::string& filename) {
+#ifdef MJSON_CPP_POSIX
+            int _fd = ::open(filename.c_str(), O_RDONLY);
+            if(_fd < 0) return;
+            struct stat _stat{};
+            if(::fstat(_fd, &_stat) == 0 && _stat.st_size > 0) {
+                void* _map = ::mmap(nullptr, static_cast<std::size_t>(_stat.st_size), PROT_READ, MAP_PRIVATE, _fd, 0);
+                if(_map != MAP_FAILED) {
+                    data_ = static_cast<const char*>(_map);
+                    size_ = static_cast<std::size_t>(_stat.st_size);
+                }
+            }
+            ::close(_fd);
+#else
+            std::ifstream ifs(filename, std::ios::binary);
+            buffer_.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+            if(!buffer_.empty()) { data_ = buffer_.data(); size_ = buffer_.size(); }
+#endif
+        }
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator = (const mapped_file&) = delete;
+        ~mapped_file() {
+#ifdef MJSON_CPP_POSIX
+            if(data_ != nullptr) ::munmap(const_cast<char*>(data_), size_);
+#endif
+        }
+
+        bool good() const { return data_ != nullptr; }
+        const char* data() const { return data_; }
+        std::size_t size() const { return size_; }
+
+    private:
+        const char* data_{nullptr};
+        std::size_t size_{0};
+#ifndef MJSON_CPP_POSIX
+        std::vector<char> buffer_;
+#endif
+    };
+
+    struct npy_header {
+        std::string dtype;               //!< descr without byte order, e.g. "f8"
+        std::vector<std::size_t> shape;
+        std::size_t offset{0};           //!< start of the C-ordered data
+    };
+
+    //! parse the header of a little-endian, C-ordered .npy file (format version 1.0 to 3.0)
+    inline bool read_npy_header(const char* data, std::size_t size, npy_header& header) {
+        if(size < 10 || std::memcmp(data, "\x93NUMPY", 6) != 0) return false;
+        auto _byte = [data](std::size_t i) { return static_cast<std::size_t>(static_cast<unsigned char>(data[i])); };
+        std::size_t _length = 0, _begin = 0;
+        if(data[6] == 1) {
+            _length = _byte(8) | (_byte(9) << 8);
+            _begin = 10;
+        } else {
+            if(size < 12) return false;
+            _length = _byte(8) | (_byte(9) << 8) | (_byte(10) << 16) | (_byte(11) << 24);
+            _begin = 12;
+        }
+        if(_begin + _length > size) return false;
+        std::string _dict(data + _begin, _length);
+
+        auto _descr = _dict.find("'descr'");
+        if(_descr == std::string::npos) return false;
+        auto _open = _dict.find('\'', _descr + 7);
+        auto _close = _dict.find('\'', _open + 1);
+        if(_open == std::string::npos || _close == std::string::npos || _close - _open < 3) return false;
+        if(_dict[_open + 1] != '<' && _dict[_open + 1] != '|') return false;
+        header.dtype = _dict.substr(_open + 2, _close - _open - 2);
+
+        auto _order = _dict.find("'fortran_order'");
+        if(_order == std::string::npos) return false;
+        _order = _dict.find_first_not_of(": ", _order + 15);
+        if(_order == std::string::npos || _dict.compare(_order, 4, "True") == 0) return false;
+
+        auto _shape = _dict.find("'shape'");
+        if(_shape == std::string::npos) return false;
+        _open = _dict.find('(', _shape);
+        _close = _dict.find(')', _open);
+        if(_open == std::string::npos || _close == std::string::npos) return false;
+        header.shape.clear();
+        const char* p = _dict.c_str() + _open + 1;
+        const char* _end = _dict.c_str() + _close;
+        while(p < _end) {
+            char* _next = nullptr;
+            auto _dim = std::strtoull(p, &_next, 10);
+            if(_next == p) { p++; continue; }
+            header.shape.push_back(static_cast<std::size_t>(_dim));
+            p = _next;
+        }
+        header.offset = _begin + _length;
+        return true;
+    }
+
+    //! shape of nested arrays, false when ragged
+    template<class T, std::enable_if_t<!is_array<T>::value && !is_ndarray<T>::value, int> = 0>
+    bool npy_shape(const T& , std::vector<std::size_t>& , std::size_t ) { return true; }
+
+    template<class T>
+    bool npy_shape(const NDArray<T>& value, std::vector<std::size_t>& shape, std::size_t ) { shape = value.shape(); return true; }
+
+    template<class T, std::enable_if_t<is_array<T>::value, int> = 0>
+    bool npy_shape(const T& value, std::vector<std::size_t>& shape, std::size_t depth) {
+        if(shape.size() == depth) shape.push_back(value.size());
+        else if(shape[depth] != value.size()) return false;
+        for(const auto& item : value) {
+            if(!npy_shape(item, shape, depth + 1)) return false;
+        }
+        return true;
+    }
+
+    template<class S, class T, std::enable_if_t<!is_array<T>::value && !is_ndarray<T>::value, int> = 0>
+    void npy_flatten(const T& value, std::vector<S>& data) { data.push_back(static_cast<S>(value)); }
+
+    template<class S, class T>
+    void npy_flatten(const NDArray<T>& value, std::vector<S>& data) {
+        for(const auto& item : value) data.push_back(static_cast<S>(item));
+    }
+
+    template<class S, class T, std::enable_if_t<is_array<T>::value, int> = 0>
+    void npy_flatten(const T& value, std::vector<S>& data) {
+        for(const auto& item : value) npy_flatten<S>(item, data);
+    }
+
+    //! write nested arrays as a version 1.0 .npy file
+    template<class T> bool write_npy(const std::string& filename, const T& value, const std::vector<std::size_t>& shape) {
+        using S = typename npy_storage<scalar_of_t<T>>::type;
+        std::string _dict = "{'descr': '<";
+        _dict += npy_storage<scalar_of_t<T>>::dtype();
+        _dict += "', 'fortran_order': False, 'shape': (";
+        for(auto dim : shape) { _dict += std::to_string(dim); _dict += ", "; }
+        if(shape.size() > 1) _dict.resize(_dict.size() - 2);
+        else if(shape.size() == 1) _dict.pop_back();
+        _dict += "), }";
+        _dict.append((64 - (10 + _dict.size() + 1) % 64) % 64, ' ');
+        _dict += '\n';
+
+        std::vector<S> _data{};
+        _data.reserve(std::accumulate(shape.begin(), shape.end(), std::size_t(1), std::multiplies<std::size_t>()));
+        npy_flatten<S>(value, _data);
+
+        std::ofstream ofs(filename, std::ios::binary | std::ios::trunc);
+        if(!ofs.good()) return false;
+        const char _preamble[10] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0,
+                                     static_cast<char>(_dict.size() & 0xff), static_cast<char>(_dict.size() >> 8)};
+        ofs.write(_preamble, sizeof(_preamble));
+        ofs.write(_dict.data(), static_cast<std::streamsize>(_dict.size()));
+        ofs.write(reinterpret_cast<const char*>(_data.data()), static_cast<std::streamsize>(_data.size() * sizeof(S)));
+        return ofs.good();
+    }
+
+    //! copy a file byte for byte, replacing the target unless both name the same file
+    inline bool copy_file(const std::string& from, const std::string& to) {
+#ifdef MJSON_CPP_POSIX
+        struct stat _from{}, _to{};
+        if(::stat(from.c_str(), &_from) != 0) return false;
+        if(::stat(to.c_str(), &_to) == 0 && _from.st_dev == _to.st_dev && _from.st_ino == _to.st_ino) return true;
+#endif
+        std::ifstream ifs(from, std::ios::binary);
+        if(!ifs.good()) return false;
+        std::ofstream ofs(to, std::ios::binary | std::ios::trunc);
+        if(!ofs.good()) return false;
+        if(ifs.peek() != std::ifstream::traits_type::eof()) ofs << ifs.rdbuf();
+        return ofs.good();
+    }
+
+    inline std::size_t base64_encoded_size(std::size_t size) { return (size + 2) / 3 * 4; }
+
+#ifdef MJSON_CPP_BASE64_SSSE3
+    inline bool has_ssse3() {
+        static const bool _has = []() {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("ssse3") != 0;
+        }();
+        return _has;
+    }
+
+    /**
+     * @brief Encode 12 bytes into 16 chars per step while 16 bytes can be loaded, returns the bytes consumed.
+     * @details Each 3-byte group is spread over four bytes by one shuffle, its 6-bit fields moved into
+     * place by two multiplies, and the 64 indices mapped to the alphabet through a 16-entry table of
+     * offsets selected by range (W. Muła and D. Lemire, "Faster Base64 Encoding and Decoding using AVX2
+     * Instructions", 2018, in its SSE form).
+     */
+    __attribute__((target("ssse3"))) inline std::size_t base64_encode_ssse3(const unsigned char* p, std::size_t size, char* out) {
+        const __m128i _spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+        const __m128i _offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                               '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+        std::size_t i = 0;
+        for(; i + 16 <= size; i += 12, out += 16) {
+            __m128i _in = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)), _spread);
+            __m128i _high = _mm_mulhi_epu16(_mm_and_si128(_in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+            __m128i _low = _mm_mullo_epi16(_mm_and_si128(_in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+            __m128i _index = _mm_or_si128(_high, _low);
+            // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+            __m128i _range = _mm_subs_epu8(_index, _mm_set1_epi8(51));
+            _range = _mm_or_si128(_range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), _index), _mm_set1_epi8(13)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_add_epi8(_mm_shuffle_epi8(_offsets, _range), _index));
+        }
+        return i;
+    }
+
+    /**
+     * @brief Decode 16 chars into 12 bytes per step while 16 bytes fit in `room`, returns the chars consumed.
+     * @details Sets `ok` to false at the first step holding a char outside the alphabet. Two multiply-adds
+     * join the four 6-bit values of each group and a shuffle drops the spare byte.
+     */
+    __attribute__((target("ssse3"))) inline std::size_t base64_decode_ssse3(const unsigned char* p, std::size_t length, unsigned char* out,
+                                                                            std::size_t room, bool& ok) {
+        const __m128i _pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        std::size_t i = 0;
+        for(; i + 16 <= length && i / 4 * 3 + 16 <= room; i += 16, out += 12) {
+            __m128i _in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            // signed compares, so bytes from 0x80 fall in no range
+            __m128i _upper = _mm_and_si128(_mm_cmpgt_epi8(_in, _mm_set1_epi8('A' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), _in));
+            __m128i _lower = _mm_and_si128(_mm_cmpgt_epi8(_in, _mm_set1_epi8('a' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), _in));
+            __m128i _digit = _mm_and_si128(_mm_cmpgt_epi8(_in, _mm_set1_epi8('0' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), _in));
+            __m128i _plus = _mm_cmpeq_epi8(_in, _mm_set1_epi8('+'));
+            __m128i _slash = _mm_cmpeq_epi8(_in, _mm_set1_epi8('/'));
+            if(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_upper, _lower), _mm_or_si128(_digit, _mm_or_si128(_plus, _slash)))) != 0xffff) {
+                ok = false;
+                return i;
+            }
+            __m128i _shift = _mm_and_si128(_upper, _mm_set1_epi8(-65));
+            _shift = _mm_or_si128(_shift, _mm_and_si128(_lower, _mm_set1_epi8(-71)));
+            _shift = _mm_or_si128(_shift, _mm_and_si128(_digit, _mm_set1_epi8(4)));
+            _shift = _mm_or_si128(_shift, _mm_and_si128(_plus, _mm_set1_epi8(19)));
+            _shift = _mm_or_si128(_shift, _mm_and_si128(_slash, _mm_set1_epi8(16)));
+            __m128i _pairs = _mm_maddubs_epi16(_mm_add_epi8(_in, _shift), _mm_set1_epi32(0x01400140));
+            __m128i _groups = _mm_madd_epi16(_pairs, _mm_set1_epi32(0x00011000));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(_groups, _pack));
+        }
+        return i;
+    }
+#endif
+
+    //! standard base64 with padding, `out` requires base64_encoded_size(size) chars
+    inline void base64_encode(const void* data, std::size_t size, char* out) {
+        static const char _table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        const auto* p = static_cast<const unsigned char*>(data);
+        std::size_t i = 0;
+#ifdef MJSON_CPP_BASE64_SSSE3
+        if(has_ssse3()) {
+            i = base64_encode_ssse3(p, size, out);
+            out += i / 3 * 4;
+        }
+#endif
+        for(; i + 3 <= size; i += 3) {
+            std::uint32_t v = (std::uint32_t(p[i]) << 16) | (std::uint32_t(p[i + 1]) << 8) | p[i + 2];
+            *out++ = _table[v >> 18];
+            *out++ = _table[(v >> 12) & 0x3f];
+            *out++ = _table[(v >> 6) & 0x3f];
+            *out++ = _table[v & 0x3f];
+        }
+        if(i < size) {
+            std::uint32_t v = std::uint32_t(p[i]) << 16;
+            if(i + 1 < size) v |= std::uint32_t(p[i + 1]) << 8;
+            *out++ = _table[v >> 18];
+            *out++ = _table[(v >> 12) & 0x3f];
+            *out++ = i + 1 < size ? _table[(v >> 6) & 0x3f] : '=';
+            *out++ = '=';
+        }
+    }
+
+    //! decode standard base64 with padding, false on malformed input
+    inline bool base64_decode(const char* in, std::size_t length, std::vector<char>& out) {
+        static const struct table {
+            unsigned char v[256];
+            table() : v() {
+                std::memset(v, 0xff, sizeof(v));
+                const char* _alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+                for(unsigned char i = 0; i < 64; i++) v[static_cast<unsigned char>(_alphabet[i])] = i;
+            }
+        } _table{};
+        if(length % 4 != 0) return false;
+        std::size_t _padding = 0;
+        if(length > 0 && in[length - 1] == '=') _padding++;
+        if(length > 1 && in[length - 2] == '=') _padding++;
+        out.resize(length / 4 * 3 - _padding);
+        auto* o = reinterpret_cast<unsigned char*>(out.data());
+        const auto* p = reinterpret_cast<const unsigned char*>(in);
+        std::size_t _full = _padding > 0 ? length - 4 : length;
+        std::size_t i = 0;
+#ifdef MJSON_CPP_BASE64_SSSE3
+        if(has_ssse3()) {
+            bool _ok = true;
+            i = base64_decode_ssse3(p, _full, o, out.size(), _ok);
+            if(!_ok) return false;
+            o += i / 4 * 3;
+        }
+#endif
+        for(; i < _full; i += 4) {
+            std::uint32_t a = _table.v[p[i]], b = _table.v[p[i + 1]], c = _table.v[p[i + 2]], d = _table.v[p[i + 3]];
+            if((a | b | c | d) & 0x80) return false;
+            std::uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+            *o++ = static_cast<unsigned char>(v >> 16);
+            *o++ = static_cast<unsigned char>(v >> 8);
+            *o++ = static_cast<unsigned char>(v);
+        }
+        if(_padding > 0) {
+            p += _full;
+            std::uint32_t a = _table.v[p[0]], b = _table.v[p[1]], c = _padding == 1 ? _table.v[p[2]] : 0;
+            if((a | b | c) & 0x80) return false;
+            std::uint32_t v = (a << 18) | (b << 12) | (c << 6);
+            *o++ = static_cast<unsigned char>(v >> 16);
+            if(_padding == 1) *o++ = static_cast<unsigned char>(v >> 8);
+        }
+        return true;
+    }
+
+    //! decode C-ordered elements of type S into nested arrays, advancing the cursor
+    template<class T, class S, std::enable_if_t<is_ndarray<T>::value, int> = 0>
+    T npy_decode(const char*& cursor, const std::vector<std::size_t>& shape, std::size_t ) {
+        T value(shape);
+        for(auto& item : value) {
+            S _item;
+            std::memcpy(&_item, cursor, sizeof(S));
+            cursor += sizeof(S);
+            item = static_cast<typename T::value_type>(_item);
+        }
+        return value;
+    }
+
+    template<class T, class S, std::enable_if_t<!is_array<T>::value && !is_ndarray<T>::value, int> = 0>
+    T npy_decode(const char*& cursor, const std::vector<std::size_t>& , std::size_t ) {
+        S _item;
+        std::memcpy(&_item, cursor, sizeof(S));
+        cursor += sizeof(S);
+        return static_cast<T>(_item);
+    }
+
+    template<class T, class S, std::enable_if_t<is_array<T>::value, int> = 0>
+    T npy_decode(const char*& cursor, const std::vector<std::size_t>& shape, std::size_t depth) {
+        T value{};
+        reserve(value, shape[depth]);
+        for(std::size_t i = 0; i < shape[depth]; i++) {
+            value.emplace_back(npy_decode<typename T::value_type, S>(cursor, shape, depth + 1));
+        }
+        return value;
+    }
+
+    //! decode concatenated rows of the given lengths into a rank-2 array
+    template<class T, class S, std::enable_if_t<!is_array<T>::value || rank<T>::value != 2, int> = 0>
+    T npy_decode_rows(const char*& , const std::vector<std::size_t>& ) { return T(); }
+
+    template<class T, class S, std::enable_if_t<is_array<T>::value && rank<T>::value == 2, int> = 0>
+    T npy_decode_rows(const char*& cursor, const std::vector<std::size_t>& lengths) {
+        T value{};
+        reserve(value, lengths.size());
+        std::vector<std::size_t> _row(1);
+        for(auto length : lengths) {
+            _row[0] = length;
+            value.emplace_back(npy_decode<typename T::value_type, S>(cursor, _row, 0));
+        }
+        return value;
+    }
+
+    }
+}
+
+namespace param {
+
+    //! json representation written by set() for complex numbers, get() accepts all of them
+    enum class ComplexFormat {
+        String, //!< "(re,im)"
+        Pair,   //!< [re, im]
+        Object  //!< {"re": re, "im": im}
+    };
+
+    //! json representation written by set() for rectangular numeric arrays, get() accepts all of them
+    enum class ArrayFormat {
+        Nested, //!< [[1.0, 2.0], [3.0, 4.0]]
+        Base64  //!< {"$dtype": "f8", "$shape": [2, 2], "$b64": "..."} with little-endian C-ordered data
+    };
+
+    //! memory pools holding the loaded document, see ParaManager::set_pool_options()
+    struct PoolOptions {
+        std::size_t chunk_size{64 * 1024}; //!< bytes requested from malloc whenever a pool runs out
+        void* buffer{nullptr};             //!< caller-owned memory used before any chunk, may be null
+        std::size_t buffer_size{0};        //!< size of `buffer` in bytes
+        bool retain{false};                //!< keep the chunks of a replaced document for the next load()
+    };
+
+    /**
+     * @brief Customization point for get/set of types outside the standard library.
+     * @details Specialize as std::true_type with static `get(manager, value_ptr, default_value)` and
+     * `set(manager, value_ptr, value)`. Specializations are friends of ParaManager and may reuse its
+     * get_/set_ for element types, see contrib.hpp.
+     */
+    template<typename T, typename = void> struct converter : std::false_type {};
+
+    class ParaManager {
+        template<typename, typename> friend struct converter;
+        friend class ConcurrentParaManager;
+
+    public:
+        ParaManager() = default;
+        ParaManager(const ParaManager&) = delete;
+        ParaManager& operator = (ParaManager&& other) noexcept {
+            this->settle_snapshot_();
+            other.settle_snapshot_();
+            this->filename_ = std::move(other.filename_);
+            this->document_ = std::move(other.document_);
+            this->buffer_ = std::move(other.buffer_);
+            this->complex_format_ = other.complex_format_;
+            this->npy_threshold_ = other.npy_threshold_;
+            this->array_format_ = other.array_format_;
+            this->direct_ = std::move(other.direct_);
+            this->lazy_ = std::move(other.lazy_);
+            other.lazy_.loaded = false;
+            this->parse_error_ = other.parse_error_;
+            this->parallel_ = other.parallel_;
+            this->parallel_min_size_ = other.parallel_min_size_;
+            this->stack_capacity_ = other.stack_capacity_;
+            // the replaced document is gone, so its pool may serve as the spare one, unless it sits in
+            // a user buffer that the options taken over from `other` no longer name
+            auto _replaced = std::move(this->pool_.pools[this->pool_.live]);
+            bool _reusable = !this->pool_.stale && this->pool_.live != other.pool_.live &&
+                             this->pool_.options.buffer == other.pool_.options.buffer &&
+                             this->pool_.options.buffer_size == other.pool_.options.buffer_size;
+            this->pool_ = std::move(other.pool_);
+            if(_reusable && this->pool_.options.retain && !this->pool_.stale && !this->pool_.pools[1 - this->pool_.live])
+                this->pool_.pools[1 - this->pool_.live] = std::move(_replaced);
+            bool _clean = !other.dirty();
+            this->generation_ = std::max(this->generation_, other.generation_) + 1;
+            this->synced_generation_ = _clean ? this->generation_ : 0;
+            this->synced_path_ = std::move(other.synced_path_);
+            this->synced_compact_ = other.synced_compact_;
+            this->synced_decimals_ = other.synced_decimals_;
+            this->dirty_keys_ = std::move(other.dirty_keys_);
+            this->layers_ = std::move(other.layers_);
+            this->layer_hits_.clear();
+            other.layer_hits_.clear();
+            other.generation_++;
+            return *this;
+        }
+        ~ParaManager() { settle_snapshot_(); }
+
+        /**
+         * @brief Pre-tokenized keypath bound to one ParaManager.
+         * @details Created by ParaManager::compile(). The resolved value is cached and reused
+         * until the document generation changes, which happens on every load, set and erase.
+         */
+        class KeyHandle {
+        public:
+            const std::string& keypath() const { return keypath_; }
+            bool valid() const { return pointer_.IsValid(); }
+
+        private:
+            friend class ParaManager;
+            KeyHandle(const ParaManager* owner, const std::string& keypath) : keypath_(keypath), pointer_(keypath.c_str()), owner_(owner) {}
+
+            std::string keypath_;
+            rapidjson::Pointer pointer_;
+            const ParaManager* owner_;
+            mutable std::size_t generation_{0};
+            mutable rapidjson::Value* value_{nullptr};
+        };
+
+        const std::string& filename() const { return this->filename_; }
+        bool has_parse_error() const { return this->parse_error_; }
+
+        void set_complex_format(ComplexFormat format) { this->complex_format_ = format; }
+        ComplexFormat complex_format() const { return this->complex_format_; }
+
+        /**
+         * @brief Store arrays with at least `elements` numbers in .npy sidecar files, 0 disables.
+         * @details The sidecar is written next to the loaded json file as "<stem>.<keypath>.npy", with the
+         * slashes of the keypath as dots and its own '.' and '%' as "%2E" and "%25", and the keypath
+         * holds a reference {"$npy": file, "shape": [...], "dtype": "f8"} that get() decodes
+         * transparently. Only rectangular arrays of real or complex numbers are eligible. save() and
+         * save_async() into another directory copy the sidecars there first.
+         */
+        void set_npy_threshold(std::size_t elements) { this->npy_threshold_ = elements; }
+        std::size_t npy_threshold() const { return this->npy_threshold_; }
+
+        void set_array_format(ArrayFormat format) { this->array_format_ = format; }
+        ArrayFormat array_format() const { return this->array_format_; }
+
+        /**
+         * @brief Parse the rectangular numeric arrays at these keypaths straight into flat buffers on load().
+         * @details The numbers go from the reader into one 8-byte-per-element block ("i8" if all are
+         * integers, "f8" otherwise) instead of a 16-byte Value each, and the keypath holds
+         * {"$raw": block, "$dtype", "$shape"}. get() of vectors and NDArray decodes the block directly
+         * and save() writes it back as nested arrays. Any other access, a get() of another type at the
+         * keypath or a get(), set() or erase() below it, first turns the block into ordinary nested
+         * arrays, so it costs one conversion and then behaves as if loaded without this option. Arrays
+         * that turn out not to be rectangular and numeric are loaded as usual. Strings are copied,
+         * `insitu` has no effect while this is set.
+         */
+        void set_direct_arrays(const std::vector<std::string>& keypaths) { this->direct_.keypaths = keypaths; }
+        const std::vector<std::string>& direct_arrays() const { return this->direct_.keypaths; }
+
+        /**
+         * @brief Make load() index the file instead of parsing it, values are parsed when first reached.
+         * @details load() keeps the file buffer and makes one pass recording where every object and
+         * array ends. get(), set() and erase() expand only the objects and arrays on their path, one
+         * level at a time, and parse the value they return. Untouched regions are never number-parsed
+         * or allocated, save() streams them straight from the buffer. Syntax errors inside a value
+         * show up as a missing value rather than in has_parse_error(). Takes precedence over
+         * set_direct_arrays(). Files of 4 GB or more are parsed eagerly. Since get() modifies the
+         * document, this is not offered by ConcurrentParaManager.
+         */
+        void set_lazy(bool lazy) { this->lazy_.enabled = lazy; }
+        bool lazy() const { return this->lazy_.enabled; }
+
+        /**
+         * @brief Configure the memory pools that hold the loaded document, from the next load() on.
+         * @details load() parses into a spare pool and only swaps it in on success, so two pools
+         * alternate and `buffer` is split into one half for each. Without `retain` the chunks of a
+         * replaced document are freed right away; with it they are kept and refilled by the next
+         * load(), so periodic reloads of a similar file settle at no chunk allocation, at the cost of
+         * holding up to twice the document memory.
+         */
+        void set_pool_options(const PoolOptions& options) {
+            this->pool_.options = options;
+            this->pool_.pools[1 - this->pool_.live].reset();
+            this->pool_.stale = true;
+        }
+        const PoolOptions& pool_options() const { return this->pool_.options; }
+
+        /**
+         * @brief Parse files of `min_size` bytes or more on `threads` threads, 0 for one per core, 1 (default) disables.
+         * @details Off by default: planning and stitching are serial, so the gain depends on the cores
+         * and the file, and on a single core it is a loss. `mjson_bench_parse` times both parsers over
+         * a range of sizes to pick `min_size` for a machine. A scan on all threads finds the large
+         * objects and arrays and a comma every few hundred kilobytes inside them. The runs of members
+         * or elements between those commas are parsed concurrently and linked into one document. The
+         * first thread parses into the document's own pool, the others into pools that borrow its
+         * retained chunks and are absorbed into it afterwards, so set_pool_options() applies as for a
+         * serial load. Files that do not split, or fail to parse, go through the serial parser, which
+         * also reports the error. Not combined with set_lazy() or set_direct_arrays(), and `insitu`
+         * has no effect on files parsed this way.
+         */
+        void set_parallel(std::size_t threads, std::size_t min_size = std::size_t(1) << 20) {
+            this->parallel_ = threads;
+            this->parallel_min_size_ = min_size;
+        }
+        std::size_t parallel() const { return this->parallel_; }
+        std::size_t parallel_min_size() const { return this->parallel_min_size_; }
+
+        KeyHandle compile(const std::string& keypath) const {
+            return KeyHandle(this, keypath);
+        }
+
+        /**
+         * @brief Load json file by path name.
+         * @details The file is read in one block into a contiguous buffer before parsing. With `insitu`
+         * the buffer is kept alive by the manager and strings are decoded in place instead of copied.
+         * A file that fails to parse sets has_parse_error() and leaves the document, its filename and
+         * its unsaved changes as they were.
+         */
+        bool load(const std::string& filename, bool insitu = false) {
+            std::vector<char> buffer{};
+            if(!read_file_(filename, buffer)) return false;
+            settle_snapshot_();
+            this->parse_error_ = false;
+            // the tape of the current document stays until the new file is known to be balanced
+            std::vector<std::pair<std::uint32_t, std::uint32_t>> _tape{};
+            if(this->lazy_.enabled && index_(buffer, _tape)) {
+                this->lazy_.tape.swap(_tape);
+                rapidjson::Document _document = next_document_();
+                std::size_t _begin = skip_space_(buffer, 0);
+                _document.SetString(rapidjson::StringRef(buffer.data() + _begin, static_cast<rapidjson::SizeType>(skip_value_(buffer, _begin) - _begin)));
+                this->document_.Swap(_document);
+                this->buffer_.swap(buffer);
+                this->direct_.blocks.clear();
+                this->lazy_.loaded = true;
+            } else if(!this->lazy_.enabled && !this->direct_.keypaths.empty() && parse_direct_(buffer)) {
+                std::vector<char>().swap(this->buffer_);
+                this->lazy_.loaded = false;
+            } else if(!this->lazy_.enabled && this->direct_.keypaths.empty() && parse_parallel_(buffer)) {
+                std::vector<char>().swap(this->buffer_);
+                this->direct_.blocks.clear();
+                this->lazy_.loaded = false;
+            } else {
+                // a failed parse keeps the previous document, and with it the buffers it refers to
+                bool _insitu = insitu && this->direct_.keypaths.empty() && !this->lazy_.enabled;
+                rapidjson::Document _document = next_document_();
+                auto _generator = [&](rapidjson::Document& document) {
+                    rapidjson::Reader _reader{};
+                    if(_insitu) {
+                        rapidjson::InsituStringStream _stream(buffer.data());
+                        this->parse_error_ = _reader.Parse<rapidjson::kParseInsituFlag>(_stream, document).IsError();
+                    } else {
+                        rapidjson::StringStream _stream(buffer.data());
+                        this->parse_error_ = _reader.Parse(_stream, document).IsError();
+                    }
+                    this->stack_capacity_ = document.GetStackCapacity();
+                    return !this->parse_error_;
+                };
+                _document.Populate(_generator);
+                if(!this->parse_error_) {
+                    this->document_.Swap(_document);
+                    if(_insitu) this->buffer_.swap(buffer); else std::vector<char>().swap(this->buffer_);
+                    this->direct_.blocks.clear();
+                    this->lazy_.loaded = false;
+                }
+            }
+            // a failed parse leaves the previous document as it was, unsaved changes included
+            if(this->parse_error_) return true;
+            swap_pools_();
+            this->layers_.clear();
+            this->layer_hits_.clear();
+            this->filename_ = filename;
+            this->generation_++;
+            mark_synced_(filename, false, 0);
+            return true;
+        }
+
+        /**
+         * @brief Load several json files as layers, lowest precedence first: {defaults, site, host, override}.
+         * @details The files are parsed concurrently and kept as separate documents. get() returns the
+         * value of the highest layer that has the keypath, and remembers which layer that was, so
+         * repeated lookups probe one document instead of all of them. Objects are not merged: get() of
+         * an object returns the winning layer's object only. set() and erase() change the last file
+         * alone, which filename() and save() refer to, so erasing a keypath there uncovers the value of
+         * the layer below. keys() lists the keypaths of all layers. Layers are parsed eagerly whatever
+         * set_lazy() says, and a plain load() drops them. Since get() updates the lookup cache, this is
+         * not offered by ConcurrentParaManager.
+         * @return false if a file cannot be read. The current document and layers are kept then, and
+         * also when a file fails to parse, which has_parse_error() reports.
+         */
+        bool load_layers(const std::vector<std::string>& filenames) {
+            if(filenames.empty()) return false;
+            std::vector<std::unique_ptr<ParaManager>> _layers(filenames.size());
+            for(auto& _layer : _layers) {
+                _layer = std::make_unique<ParaManager>();
+                _layer->set_complex_format(this->complex_format_);
+                _layer->set_npy_threshold(this->npy_threshold_);
+                _layer->set_array_format(this->array_format_);
+                _layer->set_direct_arrays(this->direct_.keypaths);
+                _layer->set_parallel(this->parallel_, this->parallel_min_size_);
+            }
+            _layers.back()->inherit_pools_(*this);
+            std::vector<char> _read(filenames.size(), 0);
+            parallel_for_(filenames.size(), filenames.size(), [&](std::size_t k, std::size_t) {
+                _read[k] = _layers[k]->load(filenames[k]);
+            });
+            if(std::find(_read.begin(), _read.end(), 0) != _read.end()) return false;
+            for(auto& _layer : _layers) {
+                if(!_layer->has_parse_error()) continue;
+                this->parse_error_ = true;
+                return true;
+            }
+            auto _top = std::move(_layers.back());
+            _layers.pop_back();
+            bool _lazy = this->lazy_.enabled;
+            *this = std::move(*_top);
+            this->lazy_.enabled = _lazy;
+            this->layers_ = std::move(_layers);
+            return true;
+        }
+
+        /**
+         * @brief Save json file by path name, use exist filename if nil.
+         * @details The document is serialized through a large FileWriteStream buffer into a temporary file
+         * next to the target, flushed to disk and renamed over the target, so a crash never leaves a
+         * truncated file behind. The target keeps its permissions. `compact` drops the indentation of the default pretty format.
+         * Doubles are written in their shortest round-trip form unless `decimals` is positive, which
+         * rounds that form half away from zero to at most that many decimal places (e.g. 3 writes
+         * 0.123456 as 0.123, 0.12351 as 0.124 and 0.9999 as 1.0).
+         * Nothing is written when the document is clean and the file was last loaded from or saved to
+         * the same path in the same format. Pending save_async() requests for the path are waited for
+         * first, so their older snapshots never replace this write.
+         */
+        bool save(const std::string& filename = std::string(), bool compact = false, int decimals = 0) {
+            const std::string& _savepath = filename.empty() ? this->filename_ : filename;
+            this->save_queue_->wait(_savepath);
+            if(is_synced_(_savepath, compact, decimals)) return true;
+            if(!copy_sidecars_(_savepath)) return false;
+            if(!write_document_(this->document_, _savepath, compact, decimals, raw_range_(), direct_data_())) return false;
+            mark_synced_(_savepath, compact, decimals);
+            return true;
+        }
+
+        /**
+         * @brief Save on a background thread from a snapshot of the current document.
+         * @details The call returns right away. The snapshot, a deep copy into a fresh pool allocator,
+         * is taken on a second background thread, and only what modifies the document waits for it:
+         * set, erase, load and the get() calls that expand values in lazy mode or of direct arrays.
+         * Other reads and save() run alongside the copy. Requests for a path whose previous request
+         * has not started yet are coalesced into it: the newest snapshot is written once and all
+         * callers share the future. Sidecars are copied along with the snapshot, a failure there
+         * fails the write. `callback` runs on the writing thread once the file is written, and must
+         * not save() to the same path, which would wait for that thread. When there is nothing to
+         * write, because no filename is known or the document is clean and already saved there, the
+         * future is ready on return and `callback` has already run on the calling thread. The
+         * manager counts as saved, for dirty() and for skipping later saves, once the write succeeded.
+         */
+        std::shared_future<bool> save_async(const std::string& filename = std::string(), bool compact = false, int decimals = 0,
+                                            std::function<void(bool)> callback = std::function<void(bool)>()) {
+            const std::string& _savepath = filename.empty() ? this->filename_ : filename;
+            if(_savepath.empty()) {
+                std::promise<bool> _failed{};
+                _failed.set_value(false);
+                if(callback) callback(false);
+                return _failed.get_future().share();
+            }
+            if(is_synced_(_savepath, compact, decimals)) {
+                std::promise<bool> _done{};
+                _done.set_value(true);
+                if(callback) callback(true);
+                return _done.get_future().share();
+            }
+            if(this->lazy_.loaded) materialize_(this->document_);
+            // runs on the queue's copying thread while everything that modifies the document waits in settle_snapshot_()
+            auto _take = [this, _savepath](DirectData& direct) {
+                if(!copy_sidecars_(_savepath)) return std::unique_ptr<rapidjson::Document>();
+                auto _snapshot = std::make_unique<rapidjson::Document>();
+                _snapshot->CopyFrom(this->document_, _snapshot->GetAllocator(), true);
+                if(!this->direct_.blocks.empty()) {
+                    copied_direct_(this->document_, *_snapshot, direct);
+                    std::sort(direct.begin(), direct.end());
+                }
+                return _snapshot;
+            };
+            return this->save_queue_->push(_take, this->generation_, _savepath, compact, decimals, std::move(callback), this->snapshot_copied_);
+        }
+
+        //! whether set/erase changed the document since it was last loaded or saved, save_async() counts once written
+        bool dirty() const {
+            return this->generation_ != this->synced_generation_ && this->generation_ != this->save_queue_->saved_generation();
+        }
+
+        //! keypaths passed to set/erase since the document was last loaded or saved
+        const std::set<std::string>& dirty_keys() const {
+            static const std::set<std::string> kClean{};
+            return dirty() ? this->dirty_keys_ : kClean;
+        }
+
+        bool erase(const std::string& keypath) {
+            settle_snapshot_();
+            rapidjson::Pointer _pointer(keypath.c_str());
+            expand_path_(_pointer);
+            DirectData _erased{};
+            auto _target = this->direct_.blocks.empty() ? nullptr : _pointer.Get(this->document_);
+            if(_target != nullptr) replaced_direct_(*_target, _erased);
+            if(!_pointer.Erase(this->document_)) return false;
+            release_direct_(_erased);
+            touch_(keypath);
+            return true;
+        }
+
+        bool erase(const KeyHandle& key) {
+            if(!key.valid()) return false;
+            settle_snapshot_();
+            expand_path_(key.pointer_);
+            DirectData _erased{};
+            auto _target = this->direct_.blocks.empty() ? nullptr : key.pointer_.Get(this->document_);
+            if(_target != nullptr) replaced_direct_(*_target, _erased);
+            if(!key.pointer_.Erase(this->document_)) return false;
+            release_direct_(_erased);
+            touch_(key.keypath_);
+            return true;
+        }
+
+        std::vector<std::string> keys() const {
+            std::vector<std::string> v{};
+            v.reserve(count_keys_(this->document_));
+            for_each_key([&v](const std::string& keypath) { v.emplace_back(keypath); });
+            return v;
+        }
+
+        /**
+         * @brief Visit the keypath of every leaf in document order.
+         * @details The callback receives one reused path buffer, copy it if it must outlive the call.
+         */
+        template<class F> void for_each_key(F&& callback) const {
+            std::string _path{};
+            _path.reserve(256);
+            for_each_key_(this->document_, _path, callback);
+            // then the keypaths of each lower layer that no layer above it has
+            for(std::size_t k = this->layers_.size(); k-- > 0;) {
+                auto _visit = [&](const std::string& keypath) {
+                    rapidjson::Pointer _pointer(keypath.c_str());
+                    if(_pointer.Get(this->document_) != nullptr) return;
+                    for(std::size_t j = k + 1; j < this->layers_.size(); j++) {
+                        if(_pointer.Get(this->layers_[j]->document_) != nullptr) return;
+                    }
+                    callback(keypath);
+                };
+                this->layers_[k]->for_each_key_(this->layers_[k]->document_, _path, _visit);
+            }
+        }
+
+        template<class T> auto get(const std::string& keypath, const T& default_val = T()) {
+            auto _ptr = find_layers_(rapidjson::Pointer(keypath.c_str()), keypath);
+            return get_<T>(readable_<T>(_ptr), default_val);
+        }
+
+        template<class T> auto get(const KeyHandle& key, const T& default_val = T()) {
+            return get_<T>(readable_<T>(resolve_(key)), default_val);
+        }
+
+        //! fill a C array in place, false if the json shape does not match (contents are then unspecified)
+        template<class T, std::size_t N> bool get(const std::string& keypath, T (&value)[N]) {
+            return get_fixed_(readable_<T[N]>(find_layers_(rapidjson::Pointer(keypath.c_str()), keypath)), value);
+        }
+
+        template<class T, std::size_t N> bool get(const KeyHandle& key, T (&value)[N]) {
+            return get_fixed_(readable_<T[N]>(resolve_(key)), value);
+        }
+
+        /**
+         * @brief Read a few keypaths of a json file without loading it: extract(file, "/a", a, "/b/c", c, ...).
+         * @details The memory-mapped file is streamed through a SAX reader. Only the requested values are built,
+         * containers that cannot hold one are skipped without allocating, and reading stops as soon
+         * as every target is filled. Targets that are missing or of another type keep their value.
+         * The loaded document is not touched.
+         * @return the number of targets filled, 0 also if the file cannot be read or parsed
+         */
+        template<class T, class... Rest>
+        std::size_t extract(const std::string& filename, const std::string& keypath, T& value, Rest&&... rest) {
+            std::vector<ExtractTarget> _targets{};
+            add_targets_(_targets, keypath, value, std::forward<Rest>(rest)...);
+            return extract_(filename, _targets);
+        }
+
+        template<class T> void set(const std::string& keypath, const T& value) {
+            settle_snapshot_();
+            rapidjson::Pointer _pointer(keypath.c_str());
+            expand_path_(_pointer);
+            auto _ptr = &_pointer.Create(this->document_);
+            touch_(keypath);
+            DirectData _replaced{};
+            replaced_direct_(*_ptr, _replaced);
+            if(!set_npy_<T>(keypath, _ptr, value)) set_<T>(_ptr, value);
+            release_direct_(_replaced);
+        }
+
+        template<class T> void set(const KeyHandle& key, const T& value) {
+            if(!key.valid()) return;
+            settle_snapshot_();
+            // with layers the cached value may belong to a lower one, but only the top layer is written
+            auto _ptr = this->layers_.empty() ? resolve_(key) : find_(key.pointer_);
+            if(_ptr == nullptr) {
+                expand_path_(key.pointer_);
+                _ptr = &key.pointer_.Create(this->document_);
+            }
+            touch_(key.keypath_);
+            DirectData _replaced{};
+            replaced_direct_(*_ptr, _replaced);
+            if(!set_npy_<T>(key.keypath_, _ptr, value)) set_<T>(_ptr, value);
+            release_direct_(_replaced);
+            key.generation_ = this->generation_;
+            key.value_ = _ptr;
+        }
+
+    protected:
+        void touch_(const std::string& keypath) {
+            this->generation_++;
+            this->dirty_keys_.insert(keypath);
+        }
+
+        bool is_synced_(const std::string& savepath, bool compact, int decimals) {
+            // adopt the last background write if it holds the current document
+            SaveQueue::Saved _saved{};
+            bool _queued = this->save_queue_->last_saved(_saved) && _saved.generation == this->generation_;
+            if(_queued && this->synced_generation_ != this->generation_) mark_synced_(_saved.savepath, _saved.compact, _saved.decimals);
+            if(dirty() || savepath.empty()) return false;
+            // both the last save() and the last background write may hold it, in different files
+            if(savepath == this->synced_path_ && compact == this->synced_compact_ && std::max(decimals, 0) == this->synced_decimals_) return true;
+            return _queued && savepath == _saved.savepath && compact == _saved.compact && std::max(decimals, 0) == _saved.decimals;
+        }
+
+        void mark_synced_(const std::string& savepath, bool compact, int decimals) {
+            this->synced_generation_ = this->generation_;
+            this->synced_path_ = savepath;
+            this->synced_compact_ = compact;
+            this->synced_decimals_ = std::max(decimals, 0);
+            this->dirty_keys_.clear();
+        }
+
+        //! [begin, end) of the buffer that unparsed values of a lazily loaded document point into
+        using RawRange = std::pair<const char*, const char*>;
+
+        RawRange raw_range_() const {
+            if(!this->lazy_.loaded) return RawRange(nullptr, nullptr);
+            return RawRange(this->buffer_.data(), this->buffer_.data() + this->buffer_.size());
+        }
+
+        //! sorted data pointers of the blocks of set_direct_arrays(), which tell them apart from user objects of the same layout
+        using DirectData = std::vector<const char*>;
+
+        //! the "$raw" data of `value` if it is laid out like a block of set_direct_arrays(), nullptr otherwise
+        static const char* direct_candidate_(const rapidjson::Value& value) {
+            if(!value.IsObject() || value.MemberCount() != 3 || value.MemberBegin()->name != "$raw") return nullptr;
+            return value.MemberBegin()->value.IsString() ? value.MemberBegin()->value.GetString() : nullptr;
+        }
+
+        DirectData direct_data_() const {
+            DirectData _data{};
+            for(auto& block : this->direct_.blocks) _data.push_back(reinterpret_cast<const char*>(block.data()));
+            std::sort(_data.begin(), _data.end());
+            return _data;
+        }
+
+        //! whether `value` is a block of set_direct_arrays() loaded by this manager or one of its layers
+        bool is_direct_(const rapidjson::Value& value) const {
+            const char* _data = direct_candidate_(value);
+            if(_data == nullptr) return false;
+            for(auto& block : this->direct_.blocks) {
+                if(reinterpret_cast<const char*>(block.data()) == _data) return true;
+            }
+            for(auto& layer : this->layers_) {
+                if(layer->is_direct_(value)) return true;
+            }
+            return false;
+        }
+
+        //! collect the data pointers in `copy`, a CopyFrom() of `value`, of the direct blocks it copied
+        void copied_direct_(const rapidjson::Value& value, const rapidjson::Value& copy, DirectData& direct) const {
+            if(is_direct_(value)) {
+                direct.push_back(copy.MemberBegin()->value.GetString());
+            } else if(value.IsObject()) {
+                auto jtr = copy.MemberBegin();
+                for(auto itr = value.MemberBegin(); itr != value.MemberEnd(); itr++, jtr++) copied_direct_(itr->value, jtr->value, direct);
+            } else if(value.IsArray()) {
+                auto jtr = copy.Begin();
+                for(auto itr = value.Begin(); itr != value.End(); itr++, jtr++) copied_direct_(*itr, *jtr, direct);
+            }
+        }
+
+        /**
+         * @brief Replace a block of set_direct_arrays() by the nested arrays it stands for, and free the block.
+         * @details Done the first time a keypath goes below or through a block, or get() reads it as
+         * anything but a flat numeric array, so that these see an ordinary document, as in lazy mode.
+         * Blocks of lower layers are expanded by their layer. Returns false if `value` is no block.
+         */
+        bool expand_direct_(rapidjson::Value& value) {
+            const char* _data = direct_candidate_(value);
+            if(_data == nullptr) return false;
+            auto _block = std::find_if(this->direct_.blocks.begin(), this->direct_.blocks.end(),
+                                       [&](const std::vector<std::uint64_t>& block) { return reinterpret_cast<const char*>(block.data()) == _data; });
+            if(_block == this->direct_.blocks.end()) {
+                for(auto& layer : this->layers_) {
+                    if(layer->expand_direct_(value)) return true;
+                }
+                return false;
+            }
+            settle_snapshot_();
+            rapidjson::Document _nested(rapidjson::kNullType, &this->document_.GetAllocator());
+            auto _generator = [&](rapidjson::Document& document) { return write_raw_(value, document); };
+            _nested.Populate(_generator);
+            if(!_nested.IsArray()) return false;
+            value.Swap(_nested);
+            this->direct_.blocks.erase(_block);
+            return true;
+        }
+
+        //! collect the data pointers of the blocks in `value` and below, which set() and erase() are about to drop
+        void replaced_direct_(const rapidjson::Value& value, DirectData& direct) const {
+            if(this->direct_.blocks.empty()) return;
+            const char* _data = direct_candidate_(value);
+            if(_data != nullptr) {
+                direct.push_back(_data);
+            } else if(value.IsObject()) {
+                for(auto itr = value.MemberBegin(); itr != value.MemberEnd(); itr++) replaced_direct_(itr->value, direct);
+            } else if(value.IsArray()) {
+                for(auto itr = value.Begin(); itr != value.End(); itr++) replaced_direct_(*itr, direct);
+            }
+        }
+
+        //! free the blocks of `direct`, which no value refers to any more
+        void release_direct_(const DirectData& direct) {
+            if(direct.empty()) return;
+            auto _released = [&](const std::vector<std::uint64_t>& block) {
+                return std::find(direct.begin(), direct.end(), reinterpret_cast<const char*>(block.data())) != direct.end();
+            };
+            this->direct_.blocks.erase(std::remove_if(this->direct_.blocks.begin(), this->direct_.blocks.end(), _released), this->direct_.blocks.end());
+        }
+
+        //! the value get<T>() decodes, with a block expanded unless T reads it flat
+        template<class T> rapidjson::Value* readable_(rapidjson::Value* value_ptr) {
+            if(!utils::is_typed_array<T>::value && value_ptr != nullptr) expand_direct_(*value_ptr);
+            return value_ptr;
+        }
+
+        /**
+         * @brief Whether get<T>() at `pointer` has a block to expand, which ConcurrentParaManager must
+         * do under the exclusive lock.
+         */
+        template<class T> bool expands_direct_(const KeyHandle& key) const { return key.valid() && expands_direct_<T>(key.pointer_); }
+
+        template<class T> bool expands_direct_(const rapidjson::Pointer& pointer) const {
+            for(auto& layer : this->layers_) {
+                if(layer->expands_direct_<T>(pointer)) return true;
+            }
+            if(this->direct_.blocks.empty() || !pointer.IsValid()) return false;
+            const rapidjson::Value* _value = &this->document_;
+            for(std::size_t i = 0; i < pointer.GetTokenCount(); i++) {
+                const auto& _token = pointer.GetTokens()[i];
+                if(is_direct_(*_value)) return true;
+                if(_value->IsObject()) {
+                    auto _member = _value->FindMember(rapidjson::Value(rapidjson::StringRef(_token.name, _token.length)));
+                    if(_member == _value->MemberEnd()) return false;
+                    _value = &_member->value;
+                } else if(_value->IsArray() && _token.index != rapidjson::kPointerInvalidIndex && _token.index < _value->Size()) {
+                    _value = &(*_value)[_token.index];
+                } else {
+                    return false;
+                }
+            }
+            return !utils::is_typed_array<T>::value && is_direct_(*_value);
+        }
+
+        static bool write_document_(const rapidjson::Value& document, const std::string& savepath, bool compact, int decimals,
+                                    RawRange raw = RawRange(nullptr, nullptr), const DirectData& direct = DirectData()) {
+            if(savepath.empty()) return false;
+            std::string _tmppath = savepath + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+#ifdef MJSON_CPP_POSIX
+            // unique across processes too, O_EXCL never reuses a leftover file, and 0666 goes through the umask
+            static std::atomic<unsigned> _counter{0};
+            _tmppath += "." + std::to_string(::getpid()) + "." + std::to_string(_counter++);
+            int _fd = ::open(_tmppath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+            if(_fd < 0) return false;
+            struct stat _target{};
+            if(::stat(savepath.c_str(), &_target) == 0) ::fchmod(_fd, _target.st_mode & 07777);
+            std::FILE* fp = ::fdopen(_fd, "wb");
+            if(fp == nullptr) {
+                ::close(_fd);
+                std::remove(_tmppath.c_str());
+                return false;
+            }
+#else
+            std::FILE* fp = std::fopen(_tmppath.c_str(), "wb");
+            if(fp == nullptr) return false;
+#endif
+
+            std::vector<char> _buffer(1 << 18);
+            rapidjson::FileWriteStream os(fp, _buffer.data(), _buffer.size());
+            bool _ok = false;
+            constexpr unsigned _flags = rapidjson::kWriteDefaultFlags | rapidjson::kWriteRoundDecimalPlacesFlag;
+            if(compact) {
+                rapidjson::Writer<rapidjson::FileWriteStream, rapidjson::UTF8<>, rapidjson::UTF8<>, rapidjson::CrtAllocator, _flags> writer(os);
+                if(decimals > 0) writer.SetMaxDecimalPlaces(decimals);
+                _ok = write_value_(document, writer, raw, direct);
+            } else {
+                rapidjson::PrettyWriter<rapidjson::FileWriteStream, rapidjson::UTF8<>, rapidjson::UTF8<>, rapidjson::CrtAllocator, _flags> writer(os);
+                writer.SetFormatOptions(rapidjson::kFormatSingleLineArray);
+                if(decimals > 0) writer.SetMaxDecimalPlaces(decimals);
+                _ok = write_value_(document, writer, raw, direct);
+            }
+            os.Flush();
+            _ok = _ok && std::fflush(fp) == 0 && !std::ferror(fp);
+#ifdef MJSON_CPP_POSIX
+            _ok = _ok && ::fsync(::fileno(fp)) == 0;
+#endif
+            _ok = std::fclose(fp) == 0 && _ok;
+#ifdef _WIN32
+            if(_ok) std::remove(savepath.c_str());
+#endif
+            _ok = _ok && std::rename(_tmppath.c_str(), savepath.c_str()) == 0;
+            if(!_ok) std::remove(_tmppath.c_str());
+#ifdef MJSON_CPP_POSIX
+            // make the rename itself durable, best effort since not every file system syncs directories
+            std::string _dir = directory_of_(savepath);
+            int _dirfd = _ok ? ::open(_dir.empty() ? "." : _dir.c_str(), O_RDONLY | O_CLOEXEC) : -1;
+            if(_dirfd >= 0) {
+                ::fsync(_dirfd);
+                ::close(_dirfd);
+            }
+#endif
+            return _ok;
+        }
+
+        //! like Value::Accept, but expands the flat blocks left by set_direct_arrays() into nested arrays
+        //! and streams unparsed values of a lazy document from their text
+        template<class W> static bool write_value_(const rapidjson::Value& value, W& writer, RawRange raw, const DirectData& direct) {
+            if(value.IsString() && value.GetString() >= raw.first && value.GetString() < raw.second) {
+                rapidjson::Reader _reader{};
+                rapidjson::MemoryStream _stream(value.GetString(), value.GetStringLength());
+                return !_reader.Parse(_stream, writer).IsError();
+            }
+            if(value.IsObject()) {
+                const char* _data = direct_candidate_(value);
+                if(_data != nullptr && std::binary_search(direct.begin(), direct.end(), _data)) return write_raw_(value, writer);
+                if(!writer.StartObject()) return false;
+                for(auto itr = value.MemberBegin(); itr != value.MemberEnd(); itr++) {
+                    if(!writer.Key(itr->name.GetString(), itr->name.GetStringLength())) return false;
+                    if(!write_value_(itr->value, writer, raw, direct)) return false;
+                }
+                return writer.EndObject(value.MemberCount());
+            }
+            if(value.IsArray()) {
+                if(!writer.StartArray()) return false;
+                for(auto itr = value.Begin(); itr != value.End(); itr++) {
+                    if(!write_value_(*itr, writer, raw, direct)) return false;
+                }
+                return writer.EndArray(value.Size());
+            }
+            return value.Accept(writer);
+        }
+
+        template<class W> static bool write_raw_(const rapidjson::Value& value, W& writer) {
+            auto _raw = value.FindMember("$raw");
+            auto _dtype = value.FindMember("$dtype");
+            auto _shape = value.FindMember("$shape");
+            if(_dtype == value.MemberEnd() || _shape == value.MemberEnd() || !_dtype->value.IsString() || !_shape->value.IsArray()) return false;
+            std::vector<std::size_t> _dims{};
+            std::size_t _count = 1;
+            for(auto& dim : _shape->value.GetArray()) {
+                if(!dim.IsUint64()) return false;
+                _dims.push_back(static_cast<std::size_t>(dim.GetUint64()));
+                _count *= _dims.back();
+            }
+            if(_dims.empty() || _count * sizeof(std::uint64_t) != _raw->value.GetStringLength()) return false;
+            const char* _cursor = _raw->value.GetString();
+            if(_dtype->value == "i8") return write_raw_items_<std::int64_t>(_cursor, _dims, 0, writer);
+            return write_raw_items_<double>(_cursor, _dims, 0, writer);
+        }
+
+        template<class S, class W>
+        static bool write_raw_items_(const char*& cursor, const std::vector<std::size_t>& shape, std::size_t depth, W& writer) {
+            if(!writer.StartArray()) return false;
+            for(std::size_t i = 0; i < shape[depth]; i++) {
+                if(depth + 1 < shape.size()) {
+                    if(!write_raw_items_<S>(cursor, shape, depth + 1, writer)) return false;
+                    continue;
+                }
+                S _item;
+                std::memcpy(&_item, cursor, sizeof(S));
+                cursor += sizeof(S);
+                if(!write_raw_item_(_item, writer)) return false;
+            }
+            return writer.EndArray(static_cast<rapidjson::SizeType>(shape[depth]));
+        }
+
+        template<class W> static bool write_raw_item_(std::int64_t item, W& writer) { return writer.Int64(item); }
+        template<class W> static bool write_raw_item_(double item, W& writer) { return writer.Double(item); }
+
+        //! record the matching close of every '{' and '[' in `tape`, false on unbalanced input
+        static bool index_(const std::vector<char>& buffer, std::vector<std::pair<std::uint32_t, std::uint32_t>>& tape) {
+            tape.clear();
+            if(buffer.size() >= std::numeric_limits<std::uint32_t>::max()) return false;
+            static const auto kStructural = []() {
+                std::array<bool, 256> _table{};
+                for(unsigned char c : {'"', '{', '}', '[', ']'}) _table[c] = true;
+                return _table;
+            }();
+            std::vector<std::size_t> _open{};
+            const char* _data = buffer.data();
+            const std::size_t _size = buffer.size() - 1;
+            for(std::size_t i = 0; i < _size; i++) {
+                if(!kStructural[static_cast<unsigned char>(_data[i])]) continue;
+                switch(_data[i]) {
+                    case '"':
+                        // jump between quotes, a quote preceded by an odd run of backslashes is escaped
+                        for(i++; ; i++) {
+                            auto _quote = static_cast<const char*>(std::memchr(_data + i, '"', _size - i));
+                            if(_quote == nullptr) return false;
+                            i = static_cast<std::size_t>(_quote - _data);
+                            std::size_t _slashes = 0;
+                            while(_data[i - 1 - _slashes] == '\\') _slashes++;
+                            if(_slashes % 2 == 0) break;
+                        }
+                        break;
+                    case '{': case '[':
+                        _open.push_back(tape.size());
+                        tape.emplace_back(static_cast<std::uint32_t>(i), 0);
+                        break;
+                    case '}': case ']':
+                        if(_open.empty() || _data[tape[_open.back()].first] != (_data[i] == '}' ? '{' : '[')) return false;
+                        tape[_open.back()].second = static_cast<std::uint32_t>(i);
+                        _open.pop_back();
+                        break;
+                    default:;
+                }
+            }
+            return _open.empty() && skip_space_(buffer, 0) < _size;
+        }
+
+        static std::size_t skip_space_(const std::vector<char>& buffer, std::size_t i) {
+            while(buffer[i] == ' ' || buffer[i] == '\n' || buffer[i] == '\r' || buffer[i] == '\t') i++;
+            return i;
+        }
+
+        //! one past the end of the value starting at i, or i itself when a bracket is not on the tape
+        std::size_t skip_value_(const std::vector<char>& buffer, std::size_t i) const {
+            switch(buffer[i]) {
+                case '{': case '[': {
+                    auto _itr = std::lower_bound(this->lazy_.tape.begin(), this->lazy_.tape.end(), std::make_pair(static_cast<std::uint32_t>(i), std::uint32_t(0)));
+                    if(_itr == this->lazy_.tape.end() || _itr->first != i) return i;
+                    return _itr->second + std::size_t(1);
+                }
+                case '"':
+                    for(i++; buffer[i] != '"'; i++) {
+                        if(buffer[i] == '\\') i++;
+                    }
+                    return i + 1;
+                default:
+                    while(buffer[i] != ',' && buffer[i] != '}' && buffer[i] != ']' && buffer[i] != ' ' &&
+                          buffer[i] != '\n' && buffer[i] != '\r' && buffer[i] != '\t' && buffer[i] != '\0') i++;
+                    return i;
+            }
+        }
+
+        /**
+         * @brief Visit the members or elements of the raw object or array starting at `begin`.
+         * @details The callback gets the key text without quotes ([key, key_end), empty for arrays)
+         * and the value text [value, value_end). Returns false on malformed input.
+         */
+        template<class F> bool raw_items_(std::size_t begin, F&& callback) const {
+            const auto& _buffer = this->buffer_;
+            const bool _object = _buffer[begin] == '{';
+            const char _close = _object ? '}' : ']';
+            std::size_t i = skip_space_(_buffer, begin + 1);
+            if(_buffer[i] == _close) return true;
+            while(true) {
+                std::size_t _key = i, _key_end = i;
+                if(_object) {
+                    if(_buffer[i] != '"') return false;
+                    _key = i + 1;
+                    _key_end = skip_value_(_buffer, i) - 1;
+                    i = skip_space_(_buffer, _key_end + 1);
+                    if(_buffer[i] != ':') return false;
+                    i = skip_space_(_buffer, i + 1);
+                }
+                std::size_t _end = skip_value_(_buffer, i);
+                if(_end == i) return false;
+                callback(_key, _key_end, i, _end);
+                i = skip_space_(_buffer, _end);
+                if(_buffer[i] == _close) return true;
+                if(_buffer[i] != ',') return false;
+                i = skip_space_(_buffer, i + 1);
+            }
+        }
+
+        //! pass a member name to `callback`, unescaped through the reader only when it contains escapes
+        template<class F> void raw_key_(std::size_t key, std::size_t key_end, F&& callback) const {
+            const char* _name = this->buffer_.data() + key;
+            auto _length = static_cast<rapidjson::SizeType>(key_end - key);
+            if(std::memchr(_name, '\\', _length) == nullptr) return callback(_name, _length);
+            rapidjson::Document _key{};
+            _key.Parse(_name - 1, _length + 2);
+            if(_key.IsString()) callback(_key.GetString(), _key.GetStringLength()); else callback(_name, _length);
+        }
+
+        rapidjson::Value raw_value_(std::size_t value, std::size_t value_end) const {
+            return rapidjson::Value(rapidjson::StringRef(this->buffer_.data() + value, static_cast<rapidjson::SizeType>(value_end - value)));
+        }
+
+        //! an unparsed value of a lazily loaded document, held as a const string over its text
+        bool is_raw_(const rapidjson::Value& value) const {
+            return this->lazy_.loaded && value.IsString() && value.GetString() >= this->buffer_.data() &&
+                   value.GetString() < this->buffer_.data() + this->buffer_.size();
+        }
+
+        //! replace a raw object or array by its members, which stay raw
+        void expand_(rapidjson::Value& value) {
+            if(!is_raw_(value)) return;
+            settle_snapshot_();
+            auto _begin = static_cast<std::size_t>(value.GetString() - this->buffer_.data());
+            if(this->buffer_[_begin] != '{' && this->buffer_[_begin] != '[') return;
+            auto& _allocator = this->document_.GetAllocator();
+            const bool _object = this->buffer_[_begin] == '{';
+            rapidjson::SizeType _count = 0;
+            bool _ok = raw_items_(_begin, [&](std::size_t, std::size_t, std::size_t, std::size_t) { _count++; });
+            rapidjson::Value _expanded(_object ? rapidjson::kObjectType : rapidjson::kArrayType);
+            if(_object) _expanded.MemberReserve(_count, _allocator); else _expanded.Reserve(_count, _allocator);
+            _ok = _ok && raw_items_(_begin, [&](std::size_t _key, std::size_t _key_end, std::size_t _value, std::size_t _end) {
+                if(!_object) {
+                    _expanded.PushBack(raw_value_(_value, _end), _allocator);
+                    return;
+                }
+                raw_key_(_key, _key_end, [&](const char* _name, rapidjson::SizeType _length) {
+                    rapidjson::Value _member(_name, _length, _allocator);
+                    _expanded.AddMember(_member, raw_value_(_value, _end), _allocator);
+                });
+            });
+            if(_ok) value.Swap(_expanded); else value.SetNull();
+        }
+
+        //! parse every raw value below and including `value`
+        void materialize_(rapidjson::Value& value) {
+            if(is_raw_(value)) {
+                settle_snapshot_();
+                rapidjson::Document _parsed(rapidjson::kNullType, &this->document_.GetAllocator());
+                _parsed.Parse(value.GetString(), value.GetStringLength());
+                if(_parsed.HasParseError()) value.SetNull(); else value.Swap(_parsed);
+            } else if(value.IsObject()) {
+                for(auto itr = value.MemberBegin(); itr != value.MemberEnd(); itr++) materialize_(itr->value);
+            } else if(value.IsArray()) {
+                for(auto itr = value.Begin(); itr != value.End(); itr++) materialize_(*itr);
+            }
+        }
+
+        //! expand the containers and direct blocks on the way to the parent of `pointer`'s target
+        rapidjson::Value* walk_(const rapidjson::Pointer& pointer, std::size_t count) {
+            rapidjson::Value* _value = &this->document_;
+            for(std::size_t i = 0; i < count && _value != nullptr; i++) {
+                const auto& _token = pointer.GetTokens()[i];
+                expand_(*_value);
+                expand_direct_(*_value);
+                if(_value->IsObject()) {
+                    auto _member = _value->FindMember(rapidjson::Value(rapidjson::StringRef(_token.name, _token.length)));
+                    _value = _member == _value->MemberEnd() ? nullptr : &_member->value;
+                } else if(_value->IsArray() && _token.index != rapidjson::kPointerInvalidIndex && _token.index < _value->Size()) {
+                    _value = &(*_value)[_token.index];
+                } else {
+                    _value = nullptr;
+                }
+            }
+            return _value;
+        }
+
+        //! Pointer::Get that parses what it returns in a lazy document and expands the direct blocks it passes
+        rapidjson::Value* find_(const rapidjson::Pointer& pointer) {
+            if(!this->lazy_.loaded && this->direct_.blocks.empty()) return pointer.Get(this->document_);
+            if(!pointer.IsValid()) return nullptr;
+            auto _value = walk_(pointer, pointer.GetTokenCount());
+            if(_value != nullptr && this->lazy_.loaded) materialize_(*_value);
+            return _value;
+        }
+
+        /**
+         * @brief find_() through the layers of load_layers(), the top one first.
+         * @details The winning layer of each keypath is cached together with the generation it was
+         * found in. Lower layers never change, so once the generation moves on only a winner from
+         * the top layer, whose values set() may have moved, needs the other layers probed again.
+         */
+        rapidjson::Value* find_layers_(const rapidjson::Pointer& pointer, const std::string& keypath) {
+            if(this->layers_.empty()) return find_(pointer);
+            LayerHit& _hit = this->layer_hits_[keypath];
+            if(_hit.generation == this->generation_) return _hit.value;
+            const std::size_t _top = this->layers_.size();
+            rapidjson::Value* _value = find_(pointer);
+            if(_value != nullptr) {
+                _hit.layer = _top;
+            } else if(_hit.generation != 0 && _hit.layer != _top) {
+                _value = _hit.value;
+            } else {
+                _hit.layer = std::string::npos;
+                for(std::size_t k = _top; k-- > 0 && _value == nullptr;) {
+                    _value = this->layers_[k]->find_(pointer);
+                    if(_value != nullptr) _hit.layer = k;
+                }
+            }
+            _hit.generation = this->generation_;
+            _hit.value = _value;
+            return _value;
+        }
+
+        //! make Pointer::Create and Pointer::Erase see real containers along `pointer`
+        void expand_path_(const rapidjson::Pointer& pointer) {
+            if((!this->lazy_.loaded && this->direct_.blocks.empty()) || !pointer.IsValid()) return;
+            auto _parent = walk_(pointer, pointer.GetTokenCount() == 0 ? 0 : pointer.GetTokenCount() - 1);
+            if(_parent == nullptr) return;
+            expand_(*_parent);
+            expand_direct_(*_parent);
+        }
+
+        //! append one escaped reference token to a json pointer
+        static void append_token_(std::string& path, const char* name, rapidjson::SizeType length) {
+            path += '/';
+            for(rapidjson::SizeType i = 0; i < length; i++) {
+                if(name[i] == '~') path += "~0";
+                else if(name[i] == '/') path += "~1";
+                else path += name[i];
+            }
+        }
+
+        struct ExtractTarget {
+            std::string keypath;
+            std::function<void(rapidjson::Value*)> assign;
+        };
+
+        void add_targets_(std::vector<ExtractTarget>& ) {}
+
+        template<class T, class... Rest>
+        void add_targets_(std::vector<ExtractTarget>& targets, const std::string& keypath, T& value, Rest&&... rest) {
+            static_assert(!utils::is_view<T>::value, "views would point into the discarded extraction buffer");
+            targets.push_back(ExtractTarget{keypath, [this, &value](rapidjson::Value* value_ptr) { value = get_<T>(value_ptr, value); }});
+            add_targets_(targets, std::forward<Rest>(rest)...);
+        }
+
+        /**
+         * @brief Forwards only the values at the target keypaths into a document, as elements of one root array.
+         * @details Paths are tracked only inside containers that may hold a target, anything else is
+         * skipped by depth counting. A target below another target is served from the outer value.
+         * Returning false once every target is covered makes the reader stop early.
+         */
+        class ExtractHandler {
+        public:
+            ExtractHandler(rapidjson::Document& document, const std::vector<ExtractTarget>& targets)
+                : document_(document), targets_(targets), covered_(targets.size(), false) {}
+
+            //! captured keypaths in the order of the root array
+            const std::vector<std::string>& captured() const { return this->captured_; }
+            bool complete() const { return this->pending_ == 0; }
+
+            bool Null() { return scalar_() == Forward ? this->document_.Null() && end_value_() : true; }
+            bool Bool(bool b) { return scalar_() == Forward ? this->document_.Bool(b) && end_value_() : true; }
+            bool Int(int i) { return scalar_() == Forward ? this->document_.Int(i) && end_value_() : true; }
+            bool Uint(unsigned i) { return scalar_() == Forward ? this->document_.Uint(i) && end_value_() : true; }
+            bool Int64(std::int64_t i) { return scalar_() == Forward ? this->document_.Int64(i) && end_value_() : true; }
+            bool Uint64(std::uint64_t i) { return scalar_() == Forward ? this->document_.Uint64(i) && end_value_() : true; }
+            bool Double(double d) { return scalar_() == Forward ? this->document_.Double(d) && end_value_() : true; }
+            bool RawNumber(const char* str, rapidjson::SizeType length, bool copy) {
+                return scalar_() == Forward ? this->document_.RawNumber(str, length, copy) && end_value_() : true;
+            }
+            bool String(const char* str, rapidjson::SizeType length, bool copy) {
+                return scalar_() == Forward ? this->document_.String(str, length, copy) && end_value_() : true;
+            }
+            bool StartObject() { return start_(false) != Forward || this->document_.StartObject(); }
+            bool Key(const char* str, rapidjson::SizeType length, bool copy) {
+                if(this->capture_) return this->document_.Key(str, length, copy);
+                if(this->skip_) return true;
+                this->path_.resize(this->frames_.back().length);
+                append_token_(this->path_, str, length);
+                return true;
+            }
+            bool EndObject(rapidjson::SizeType memberCount) {
+                if(this->capture_) return this->document_.EndObject(memberCount) && (--this->capture_ != 0 || end_value_());
+                return end_();
+            }
+            bool StartArray() { return start_(true) != Forward || this->document_.StartArray(); }
+            bool EndArray(rapidjson::SizeType elementCount) {
+                if(this->capture_) return this->document_.EndArray(elementCount) && (--this->capture_ != 0 || end_value_());
+                return end_();
+            }
+
+        private:
+            enum Action { Forward, Track, Skip };
+
+            struct Frame {
+                std::size_t length;
+                std::size_t index;
+                bool array;
+            };
+
+            Action scalar_() {
+                if(this->capture_) return Forward;
+                if(this->skip_) return Skip;
+                return begin_value_() ? Forward : Skip;
+            }
+
+            Action start_(bool array) {
+                if(this->capture_) {
+                    this->capture_++;
+                    return Forward;
+                }
+                if(this->skip_) {
+                    this->skip_++;
+                    return Skip;
+                }
+                if(begin_value_()) {
+                    this->capture_ = 1;
+                    return Forward;
+                }
+                if(!may_contain_()) {
+                    this->skip_ = 1;
+                    return Skip;
+                }
+                this->frames_.push_back(Frame{this->path_.size(), 0, array});
+                return Track;
+            }
+
+            bool end_() {
+                if(this->skip_) this->skip_--; else this->frames_.pop_back();
+                return true;
+            }
+
+            //! set path_ for the value that starts now, true if it is a target to capture
+            bool begin_value_() {
+                if(!this->frames_.empty() && this->frames_.back().array) {
+                    auto& _frame = this->frames_.back();
+                    this->path_.resize(_frame.length);
+                    this->path_ += '/';
+                    this->path_ += std::to_string(_frame.index++);
+                }
+                bool _capture = false;
+                for(std::size_t i = 0; i < this->targets_.size() && !_capture; i++) {
+                    _capture = !this->covered_[i] && this->targets_[i].keypath == this->path_;
+                }
+                if(!_capture) return false;
+                for(std::size_t i = 0; i < this->targets_.size(); i++) {
+                    if(this->covered_[i] || (this->targets_[i].keypath != this->path_ && !below_(i))) continue;
+                    this->covered_[i] = true;
+                    this->pending_--;
+                }
+                this->captured_.push_back(this->path_);
+                return true;
+            }
+
+            //! whether target i lies strictly inside the value at path_
+            bool below_(std::size_t i) const {
+                const auto& _keypath = this->targets_[i].keypath;
+                return _keypath.size() > this->path_.size() && _keypath.compare(0, this->path_.size(), this->path_) == 0 && _keypath[this->path_.size()] == '/';
+            }
+
+            bool may_contain_() const {
+                for(std::size_t i = 0; i < this->targets_.size(); i++) {
+                    if(!this->covered_[i] && below_(i)) return true;
+                }
+                return false;
+            }
+
+            //! a captured value is complete, stop the reader if nothing is pending
+            bool end_value_() const { return this->capture_ != 0 || this->pending_ != 0; }
+
+            rapidjson::Document& document_;
+            const std::vector<ExtractTarget>& targets_;
+            std::vector<bool> covered_;
+            std::size_t pending_{targets_.size()};
+            std::vector<std::string> captured_;
+            std::vector<Frame> frames_;
+            std::string path_;
+            std::size_t capture_{0};
+            std::size_t skip_{0};
+        };
+
+        std::size_t extract_(const std::string& filename, const std::vector<ExtractTarget>& targets) {
+            utils::mapped_file _map(filename);
+            if(!_map.good()) return 0;
+            rapidjson::MemoryStream _stream(_map.data(), _map.size());
+            rapidjson::Document _document{};
+            std::vector<std::string> _captured{};
+            auto _generator = [&](rapidjson::Document& document) {
+                ExtractHandler _handler(document, targets);
+                rapidjson::Reader _reader{};
+                document.StartArray();
+                auto _result = _reader.Parse(_stream, _handler);
+                if(_result.IsError() && !(_result.Code() == rapidjson::kParseErrorTermination && _handler.complete())) return false;
+                _captured = _handler.captured();
+                return document.EndArray(static_cast<rapidjson::SizeType>(_captured.size()));
+            };
+            _document.Populate(_generator);
+            if(!_document.IsArray()) return 0;
+
+            std::size_t _filled = 0;
+            for(const auto& target : targets) {
+                for(std::size_t i = 0; i < _captured.size(); i++) {
+                    const auto& _path = _captured[i];
+                    if(target.keypath.compare(0, _path.size(), _path) != 0) continue;
+                    if(target.keypath.size() != _path.size() && target.keypath[_path.size()] != '/') continue;
+                    auto _ptr = rapidjson::Pointer(target.keypath.c_str() + _path.size()).Get(_document[static_cast<rapidjson::SizeType>(i)]);
+                    if(_ptr == nullptr) break;
+                    target.assign(_ptr);
+                    _filled++;
+                    break;
+                }
+            }
+            return _filled;
+        }
+
+        /**
+         * @brief Forwards SAX events into a document, except for numeric arrays at the direct keypaths.
+         * @details Those are collected into a flat buffer while the shape is checked, and handed to the
+         * document as one {"$raw", "$dtype", "$shape"} object. Anything else inside them aborts the
+         * parse so that load() can fall back to a plain Parse().
+         */
+        class DirectHandler {
+        public:
+            DirectHandler(rapidjson::Document& document, const std::vector<std::string>& keypaths, std::deque<std::vector<std::uint64_t>>& blocks)
+                : document_(document), keypaths_(keypaths), blocks_(blocks) {}
+
+            bool Null() { return !this->depth_ && (element_(false), this->document_.Null()); }
+            bool Bool(bool b) { return !this->depth_ && (element_(false), this->document_.Bool(b)); }
+            bool Int(int i) { return this->depth_ ? integer_(i) : (element_(false), this->document_.Int(i)); }
+            bool Uint(unsigned i) { return this->depth_ ? integer_(i) : (element_(false), this->document_.Uint(i)); }
+            bool Int64(std::int64_t i) { return this->depth_ ? integer_(i) : (element_(false), this->document_.Int64(i)); }
+            bool Uint64(std::uint64_t i) {
+                if(!this->depth_) return element_(false), this->document_.Uint64(i);
+                return i <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()) && integer_(static_cast<std::int64_t>(i));
+            }
+            bool Double(double d) { return this->depth_ ? real_(d) : (element_(false), this->document_.Double(d)); }
+            bool RawNumber(const char* str, rapidjson::SizeType length, bool copy) {
+                return !this->depth_ && (element_(false), this->document_.RawNumber(str, length, copy));
+            }
+            bool String(const char* str, rapidjson::SizeType length, bool copy) {
+                return !this->depth_ && (element_(false), this->document_.String(str, length, copy));
+            }
+            bool StartObject() {
+                if(this->depth_) return false;
+                element_(true);
+                this->frames_.push_back(Frame{this->path_.size(), 0, false});
+                return this->document_.StartObject();
+            }
+            bool Key(const char* str, rapidjson::SizeType length, bool copy) {
+                this->path_.resize(this->frames_.back().length);
+                append_token_(this->path_, str, length);
+                return this->document_.Key(str, length, copy);
+            }
+            bool EndObject(rapidjson::SizeType memberCount) {
+                this->frames_.pop_back();
+                return this->document_.EndObject(memberCount);
+            }
+            bool StartArray() {
+                if(this->depth_) {
+                    if(this->ndim_ != 0 && this->depth_ >= this->ndim_) return false;
+                    this->counts_[this->depth_ - 1]++;
+                    this->depth_++;
+                    if(this->counts_.size() < this->depth_) this->counts_.push_back(0); else this->counts_[this->depth_ - 1] = 0;
+                    if(this->shape_.size() < this->depth_) this->shape_.push_back(unknown_());
+                    return true;
+                }
+                element_(true);
+                if(std::find(this->keypaths_.begin(), this->keypaths_.end(), this->path_) != this->keypaths_.end()) {
+                    this->depth_ = 1;
+                    this->ndim_ = 0;
+                    this->counts_.assign(1, 0);
+                    this->shape_.assign(1, unknown_());
+                    this->words_.clear();
+                    this->is_real_ = false;
+                    return true;
+                }
+                this->frames_.push_back(Frame{this->path_.size(), 0, true});
+                return this->document_.StartArray();
+            }
+            bool EndArray(rapidjson::SizeType elementCount) {
+                if(!this->depth_) {
+                    this->frames_.pop_back();
+                    return this->document_.EndArray(elementCount);
+                }
+                auto& _dim = this->shape_[this->depth_ - 1];
+                if(_dim == unknown_()) _dim = elementCount;
+                else if(_dim != elementCount) return false;
+                return --this->depth_ != 0 || finish_();
+            }
+
+        private:
+            struct Frame {
+                std::size_t length;
+                std::size_t index;
+                bool array;
+            };
+
+            static std::size_t unknown_() { return std::numeric_limits<std::size_t>::max(); }
+
+            //! set path_ to the keypath of the value that starts now
+            void element_(bool container) {
+                if(this->frames_.empty() || !this->frames_.back().array) return;
+                auto& _frame = this->frames_.back();
+                if(container) {
+                    this->path_.resize(_frame.length);
+                    this->path_ += '/';
+                    this->path_ += std::to_string(_frame.index);
+                }
+                _frame.index++;
+            }
+
+            bool leaf_() {
+                if(this->ndim_ == 0) this->ndim_ = this->depth_;
+                if(this->depth_ != this->ndim_) return false;
+                this->counts_[this->depth_ - 1]++;
+                return true;
+            }
+
+            //! words_ holds int64 or double bit patterns, switching to double on the first non-integer
+            template<class S> void push_(S item) {
+                std::uint64_t _word;
+                std::memcpy(&_word, &item, sizeof(_word));
+                this->words_.push_back(_word);
+            }
+
+            bool integer_(std::int64_t i) {
+                if(!leaf_()) return false;
+                if(this->is_real_) push_(static_cast<double>(i)); else push_(i);
+                return true;
+            }
+
+            bool real_(double d) {
+                if(!leaf_()) return false;
+                if(!this->is_real_) {
+                    for(auto& word : this->words_) {
+                        double _item = static_cast<double>(static_cast<std::int64_t>(word));
+                        std::memcpy(&word, &_item, sizeof(word));
+                    }
+                    this->is_real_ = true;
+                }
+                push_(d);
+                return true;
+            }
+
+            //! the block is kept by the manager and referenced, not copied, by the document
+            bool finish_() {
+                if(this->ndim_ == 0 || this->shape_.size() != this->ndim_) return false;
+                std::size_t _bytes = sizeof(std::uint64_t) * this->words_.size();
+                if(_bytes >= std::numeric_limits<rapidjson::SizeType>::max()) return false;
+                this->words_.push_back(0);  // the string terminator
+                this->blocks_.emplace_back(std::move(this->words_));
+                this->words_ = std::vector<std::uint64_t>();
+                const char* _data = reinterpret_cast<const char*>(this->blocks_.back().data());
+                bool _ok = this->document_.StartObject() &&
+                           this->document_.Key("$raw", 4, false) && this->document_.String(_data, static_cast<rapidjson::SizeType>(_bytes), false) &&
+                           this->document_.Key("$dtype", 6, false) && this->document_.String(this->is_real_ ? "f8" : "i8", 2, false) &&
+                           this->document_.Key("$shape", 6, false) && this->document_.StartArray();
+                for(auto dim : this->shape_) _ok = _ok && this->document_.Uint64(dim);
+                return _ok && this->document_.EndArray(static_cast<rapidjson::SizeType>(this->shape_.size())) && this->document_.EndObject(3);
+            }
+
+            rapidjson::Document& document_;
+            const std::vector<std::string>& keypaths_;
+            std::deque<std::vector<std::uint64_t>>& blocks_;
+            std::vector<Frame> frames_;
+            std::string path_;
+            std::size_t depth_{0};
+            std::size_t ndim_{0};
+            std::vector<std::size_t> counts_;
+            std::vector<std::size_t> shape_;
+            std::vector<std::uint64_t> words_;
+            bool is_real_{false};
+        };
+
+        //! parse into a fresh document so a failure leaves document_ untouched for the fallback
+        bool parse_direct_(const std::vector<char>& buffer) {
+            rapidjson::Document _document = next_document_();
+            std::deque<std::vector<std::uint64_t>> _blocks{};
+            bool _ok = false;
+            auto _generator = [&](rapidjson::Document& document) {
+                DirectHandler _handler(document, this->direct_.keypaths, _blocks);
+                rapidjson::Reader _reader{};
+                rapidjson::StringStream _stream(buffer.data());
+                _ok = !_reader.Parse(_stream, _handler).IsError();
+                this->stack_capacity_ = document.GetStackCapacity();
+                return _ok;
+            };
+            _document.Populate(_generator);
+            if(!_ok) return false;
+            this->document_.Swap(_document);
+            this->direct_.blocks.swap(_blocks);
+            return true;
+        }
+
+        /**
+         * @brief Empty document on the spare pool, recycled or cleared per the pool options, for load() to parse into.
+         * @details Its parse stack starts at the peak size of the previous parse instead of growing to it again.
+         */
+        rapidjson::Document next_document_() {
+            auto& _pool = this->pool_.pools[1 - this->pool_.live];
+            std::size_t _stack = std::max<std::size_t>(this->stack_capacity_, 1024); // rapidjson's default
+            if(_pool) {
+                if(this->pool_.options.retain) _pool->Recycle(); else _pool->Clear();
+                return rapidjson::Document(_pool.get(), _stack);
+            }
+            const PoolOptions& _options = this->pool_.options;
+            std::size_t _half = _options.buffer ? _options.buffer_size / 2 / sizeof(std::max_align_t) * sizeof(std::max_align_t) : 0;
+            if(_half > 64) {
+                char* _begin = static_cast<char*>(_options.buffer) + _half * (1 - this->pool_.live);
+                _pool = std::make_unique<rapidjson::MemoryPoolAllocator<>>(_begin, _half, _options.chunk_size);
+            } else {
+                _pool = std::make_unique<rapidjson::MemoryPoolAllocator<>>(_options.chunk_size);
+            }
+            return rapidjson::Document(_pool.get(), _stack);
+        }
+
+        //! continue the pool alternation of `from`, whose document this manager is about to replace
+        void inherit_pools_(ParaManager& from) {
+            this->pool_.options = from.pool_.options;
+            this->pool_.live = from.pool_.live;
+            this->stack_capacity_ = from.stack_capacity_;
+            if(!from.pool_.stale) this->pool_.pools[1 - this->pool_.live] = std::move(from.pool_.pools[1 - from.pool_.live]);
+        }
+
+        //! after next_document_() was swapped into document_, its pool is live and the old one spare
+        void swap_pools_() {
+            this->pool_.live = 1 - this->pool_.live;
+            auto& _spare = this->pool_.pools[1 - this->pool_.live];
+            if(this->pool_.stale) _spare.reset(); else if(_spare && !this->pool_.options.retain) _spare->Clear();
+            this->pool_.stale = false;
+        }
+
+        /**
+         * @brief Large object or array of a parallel load.
+         * @details Its members or elements are cut into runs at sampled commas and around its large
+         * children. A piece is either a run [begin, end) parsed by one task, or a large child whose
+         * member name (for objects) is [begin, end).
+         */
+        struct ParallelNode {
+            struct Piece {
+                std::size_t begin, end;
+                std::size_t child;  //!< node index, or npos for a run
+                std::size_t task;   //!< index of the run in the task list
+            };
+            std::size_t open, close;
+            std::vector<std::size_t> cuts;
+            std::vector<std::size_t> children;
+            std::vector<Piece> pieces;
+        };
+
+        //! position of the opening quote of the member name that precedes the value at `i`, npos if malformed
+        static std::size_t member_start_(const std::vector<char>& buffer, std::size_t i) {
+            auto _back = [&](std::size_t j) {
+                while(j > 0 && (buffer[j - 1] == ' ' || buffer[j - 1] == '\n' || buffer[j - 1] == '\r' || buffer[j - 1] == '\t')) j--;
+                return j;
+            };
+            i = _back(i);
+            if(i == 0 || buffer[i - 1] != ':') return std::string::npos;
+            i = _back(i - 1);
+            if(i < 2 || buffer[i - 1] != '"') return std::string::npos;
+            for(i -= 2; ; i--) {
+                while(i > 0 && buffer[i] != '"') i--;
+                if(buffer[i] != '"') return std::string::npos;
+                std::size_t _slashes = 0;
+                while(_slashes < i && buffer[i - 1 - _slashes] == '\\') _slashes++;
+                if(_slashes % 2 == 0) return i;
+                if(i == 0) return std::string::npos;
+            }
+        }
+
+        //! call fn(k, t) for every k below `count` on up to `threads` threads, t being the thread index
+        template<class F> static void parallel_for_(std::size_t threads, std::size_t count, F&& fn) {
+            std::atomic<std::size_t> _next{0};
+            auto _work = [&](std::size_t t) {
+                for(std::size_t k = _next++; k < count; k = _next++) fn(k, t);
+            };
+            std::vector<std::thread> _workers{};
+            for(std::size_t t = 1; t < std::min(threads, count); t++) _workers.emplace_back(_work, t);
+            _work(0);
+            for(auto& _worker : _workers) _worker.join();
+        }
+
+        /**
+         * @brief Find the objects and arrays of at least `grain` bytes, and split them into pieces.
+         * @details The text is scanned in slices of grain/2 bytes on `threads` threads. A first pass
+         * counts the quotes of each slice, which tells whether the next one starts inside a string.
+         * The second pass matches the brackets within each slice and keeps only what crosses it: the
+         * unmatched brackets, and the first comma of each container they belong to. Every container
+         * of at least `grain` bytes crosses a slice, so merging the slices in order finds them all,
+         * together with a comma about every `grain` bytes to cut them at. The root is the last node.
+         * Returns false if the text is not one object or array, or if its brackets do not match.
+         */
+        static bool plan_parallel_(const std::vector<char>& buffer, std::size_t grain, std::size_t threads, std::vector<ParallelNode>& nodes) {
+            static const auto kStructural = []() {
+                std::array<bool, 256> _table{};
+                for(unsigned char c : {'"', '{', '}', '[', ']', ','}) _table[c] = true;
+                return _table;
+            }();
+            struct Open { std::size_t open, comma; };
+            struct Slice {
+                std::size_t quotes{0};
+                bool ok{true};
+                std::vector<std::size_t> outer{};  //!< first comma of each enclosing level, and the unmatched closes between them
+                std::vector<Open> opens{};         //!< unmatched opens with their first comma
+            };
+            const char* _data = buffer.data();
+            const std::size_t _size = buffer.size() - 1;
+            const std::size_t _width = std::max<std::size_t>(grain / 2, 1);
+            std::vector<Slice> _slices((_size + _width - 1) / _width);
+            // first unescaped quote in [i, end), or end
+            auto _quote = [&](std::size_t i, std::size_t end) {
+                for(;; i++) {
+                    auto _found = static_cast<const char*>(std::memchr(_data + i, '"', end - i));
+                    if(_found == nullptr) return end;
+                    i = static_cast<std::size_t>(_found - _data);
+                    std::size_t _slashes = 0;
+                    while(_slashes < i && _data[i - 1 - _slashes] == '\\') _slashes++;
+                    if(_slashes % 2 == 0) return i;
+                }
+            };
+            parallel_for_(threads, _slices.size(), [&](std::size_t k, std::size_t) {
+                const std::size_t _end = std::min(_size, (k + 1) * _width);
+                for(std::size_t i = _quote(k * _width, _end); i < _end; i = _quote(i + 1, _end)) _slices[k].quotes++;
+            });
+            std::vector<bool> _in_string(_slices.size());
+            bool _odd = false;
+            for(std::size_t k = 0; k < _slices.size(); k++) {
+                _in_string[k] = _odd;
+                _odd ^= _slices[k].quotes % 2 == 1;
+            }
+            if(_odd) return false;
+            parallel_for_(threads, _slices.size(), [&](std::size_t k, std::size_t) {
+                Slice& _slice = _slices[k];
+                const std::size_t _end = std::min(_size, (k + 1) * _width);
+                std::vector<Open> _local{};
+                bool _comma = false;
+                std::size_t i = k * _width;
+                if(_in_string[k]) i = _quote(i, _end) + 1;
+                for(; i < _end; i++) {
+                    if(!kStructural[static_cast<unsigned char>(_data[i])]) continue;
+                    switch(_data[i]) {
+                        case '"':
+                            i = _quote(i + 1, _end);
+                            break;
+                        case ',':
+                            if(!_local.empty()) {
+                                if(_local.back().comma == std::string::npos) _local.back().comma = i;
+                            } else if(!_comma) {
+                                _slice.outer.push_back(i);
+                                _comma = true;
+                            }
+                            break;
+                        case '{': case '[':
+                            _local.push_back({i, std::string::npos});
+                            break;
+                        case '}': case ']':
+                            if(_local.empty()) {
+                                _slice.outer.push_back(i);
+                                _comma = false;
+                            } else if(_data[_local.back().open] != (_data[i] == '}' ? '{' : '[')) {
+                                _slice.ok = false;
+                                return;
+                            } else {
+                                _local.pop_back();
+                            }
+                            break;
+                        default:;
+                    }
+                }
+                _slice.opens = std::move(_local);
+            });
+            // cuts and large children of the open containers, each frame owns the tail from its marks on
+            struct Frame { std::size_t open, next_cut, cuts, children; };
+            std::vector<Frame> _open{};
+            std::vector<std::size_t> _cuts{}, _children{};
+            const std::size_t _root = skip_space_(buffer, 0);
+            auto _comma = [&](std::size_t i) {
+                if(i == std::string::npos || i < _open.back().next_cut) return;
+                _cuts.push_back(i);
+                _open.back().next_cut = i + grain;
+            };
+            for(auto& _slice : _slices) {
+                if(!_slice.ok) return false;
+                for(std::size_t i : _slice.outer) {
+                    if(_open.empty()) return false;
+                    if(_data[i] == ',') {
+                        _comma(i);
+                        continue;
+                    }
+                    if(_data[_open.back().open] != (_data[i] == '}' ? '{' : '[')) return false;
+                    const Frame _frame = _open.back();
+                    bool _large = i - _frame.open >= grain;
+                    if(_large) {
+                        ParallelNode _node{};
+                        _node.open = _frame.open;
+                        _node.close = i;
+                        _node.cuts.assign(_cuts.begin() + _frame.cuts, _cuts.end());
+                        _node.children.assign(_children.begin() + _frame.children, _children.end());
+                        nodes.push_back(std::move(_node));
+                    }
+                    _cuts.resize(_frame.cuts);
+                    _children.resize(_frame.children);
+                    if(_large) _children.push_back(nodes.size() - 1);
+                    _open.pop_back();
+                    if(_open.empty() && skip_space_(buffer, i + 1) != _size) return false;
+                }
+                for(auto& _local : _slice.opens) {
+                    if(_open.empty() && _local.open != _root) return false;
+                    _open.push_back({_local.open, _local.open + grain, _cuts.size(), _children.size()});
+                    _comma(_local.comma);
+                }
+            }
+            if(!_open.empty() || nodes.empty() || nodes.back().open != _root) return false;
+            for(auto& _node : nodes) {
+                // walk the cuts and large children in order; runs between them exclude the separating commas
+                const bool _object = _data[_node.open] == '{';
+                std::size_t _begin = _node.open + 1, _cut = 0;
+                for(std::size_t _index : _node.children) {
+                    const ParallelNode& _child = nodes[_index];
+                    for(; _cut < _node.cuts.size() && _node.cuts[_cut] < _child.open; _cut++) {
+                        _node.pieces.push_back({_begin, _node.cuts[_cut], std::string::npos, 0});
+                        _begin = _node.cuts[_cut] + 1;
+                    }
+                    std::size_t _start = _object ? member_start_(buffer, _child.open) : _child.open;
+                    if(_start == std::string::npos || _start < _begin) return false;
+                    std::size_t _end = _start;
+                    while(_end > _begin && (_data[_end - 1] == ' ' || _data[_end - 1] == '\n' || _data[_end - 1] == '\r' || _data[_end - 1] == '\t')) _end--;
+                    if(_end > _begin) {
+                        if(_data[_end - 1] != ',') return false;
+                        _node.pieces.push_back({_begin, _end - 1, std::string::npos, 0});
+                    }
+                    _node.pieces.push_back({_start + 1, _object ? _start + 1 : _start, _index, 0});
+                    if(_object) _node.pieces.back().end = skip_value_string_(buffer, _start) - 1;
+                    _begin = skip_space_(buffer, _child.close + 1);
+                    if(_data[_begin] == ',') _begin++; else if(_begin != _node.close) return false;
+                    while(_cut < _node.cuts.size() && _node.cuts[_cut] < _begin) _cut++;
+                }
+                for(; _cut < _node.cuts.size(); _cut++) {
+                    _node.pieces.push_back({_begin, _node.cuts[_cut], std::string::npos, 0});
+                    _begin = _node.cuts[_cut] + 1;
+                }
+                _node.pieces.push_back({_begin, _node.close, std::string::npos, 0});
+            }
+            return true;
+        }
+
+        //! one past the closing quote of the string starting at i
+        static std::size_t skip_value_string_(const std::vector<char>& buffer, std::size_t i) {
+            for(i++; buffer[i] != '"'; i++) {
+                if(buffer[i] == '\\') i++;
+            }
+            return i + 1;
+        }
+
+        /**
+         * @brief Parse the members or elements in [begin, end) of a container into the root of `part`.
+         * @details Each value goes through the reader on its own, names of members too, so the run
+         * needs no enclosing brackets. Fails unless the run is empty or a comma-separated list.
+         */
+        static bool parse_run_(const std::vector<char>& buffer, std::size_t begin, std::size_t end, bool object, rapidjson::Document& part) {
+            bool _ok = false;
+            auto _generator = [&](rapidjson::Document& document) {
+                rapidjson::Reader _reader{};
+                auto _value = [&](std::size_t& i) {
+                    rapidjson::StringStream _stream(buffer.data() + i);
+                    if(_reader.Parse<rapidjson::kParseStopWhenDoneFlag>(_stream, document).IsError()) return false;
+                    i += _stream.Tell();
+                    return i <= end;
+                };
+                rapidjson::SizeType _count = 0;
+                if(!(object ? document.StartObject() : document.StartArray())) return false;
+                std::size_t i = skip_space_(buffer, begin);
+                while(i < end) {
+                    if(object) {
+                        if(buffer[i] != '"' || !_value(i)) return false;
+                        i = skip_space_(buffer, i);
+                        if(buffer[i] != ':') return false;
+                        i = skip_space_(buffer, i + 1);
+                    }
+                    if(!_value(i)) return false;
+                    _count++;
+                    i = skip_space_(buffer, i);
+                    if(i == end) break;
+                    if(buffer[i] != ',') return false;
+                    i = skip_space_(buffer, i + 1);
+                    if(i >= end) return false;
+                }
+                _ok = i == end && (object ? document.EndObject(_count) : document.EndArray(_count));
+                return _ok;
+            };
+            part.Populate(_generator);
+            return _ok;
+        }
+
+        //! link the parsed runs and large children of `nodes[index]` into one value on `allocator`
+        rapidjson::Value stitch_(std::vector<ParallelNode>& nodes, std::vector<std::unique_ptr<rapidjson::Document>>& parts,
+                                 std::size_t index, rapidjson::MemoryPoolAllocator<>& allocator) const {
+            const ParallelNode& _node = nodes[index];
+            const bool _object = this->buffer_[_node.open] == '{';
+            rapidjson::SizeType _count = 0;
+            for(auto& _piece : _node.pieces) {
+                if(_piece.child != std::string::npos) _count++;
+                else _count += _object ? parts[_piece.task]->MemberCount() : parts[_piece.task]->Size();
+            }
+            rapidjson::Value _value(_object ? rapidjson::kObjectType : rapidjson::kArrayType);
+            if(_object) _value.MemberReserve(_count, allocator); else _value.Reserve(_count, allocator);
+            for(auto& _piece : _node.pieces) {
+                if(_piece.child == std::string::npos) {
+                    rapidjson::Document& _part = *parts[_piece.task];
+                    if(_object) {
+                        for(auto itr = _part.MemberBegin(); itr != _part.MemberEnd(); itr++) _value.AddMember(itr->name, itr->value, allocator);
+                    } else {
+                        for(auto itr = _part.Begin(); itr != _part.End(); itr++) _value.PushBack(*itr, allocator);
+                    }
+                    continue;
+                }
+                rapidjson::Value _child = stitch_(nodes, parts, _piece.child, allocator);
+                if(!_object) {
+                    _value.PushBack(_child, allocator);
+                    continue;
+                }
+                raw_key_(_piece.begin, _piece.end, [&](const char* _name, rapidjson::SizeType _length) {
+                    rapidjson::Value _member(_name, _length, allocator);
+                    _value.AddMember(_member, _child, allocator);
+                });
+            }
+            return _value;
+        }
+
+        //! parse on parallel_ threads per set_parallel(), false leaves document_ untouched for the serial parser
+        bool parse_parallel_(std::vector<char>& buffer) {
+            std::size_t _threads = this->parallel_ ? this->parallel_ : std::max(1u, std::thread::hardware_concurrency());
+            if(_threads < 2 || buffer.size() < std::max<std::size_t>(this->parallel_min_size_, 1)) return false;
+            std::vector<ParallelNode> _nodes{};
+            std::size_t _grain = std::max<std::size_t>(buffer.size() / (_threads * 8), 64 * 1024);
+            if(!plan_parallel_(buffer, _grain, _threads, _nodes)) return false;
+            std::vector<std::pair<std::size_t, std::size_t>> _tasks{};  // (node, piece)
+            for(std::size_t n = 0; n < _nodes.size(); n++) {
+                for(std::size_t p = 0; p < _nodes[n].pieces.size(); p++) {
+                    if(_nodes[n].pieces[p].child != std::string::npos) continue;
+                    _nodes[n].pieces[p].task = _tasks.size();
+                    _tasks.emplace_back(n, p);
+                }
+            }
+            _threads = std::min(_threads, _tasks.size());
+            // thread 0 fills the spare pool itself, with the user buffer and retained chunks of
+            // set_pool_options(); the others borrow a share of those chunks and give all back below
+            rapidjson::Document _document = next_document_();
+            auto& _allocator = _document.GetAllocator();
+            const std::size_t _share = _allocator.Capacity() / _threads;
+            std::vector<std::unique_ptr<rapidjson::MemoryPoolAllocator<>>> _pools{};
+            std::vector<rapidjson::MemoryPoolAllocator<>*> _allocators{&_allocator};
+            for(std::size_t t = 1; t < _threads; t++) {
+                _pools.push_back(std::make_unique<rapidjson::MemoryPoolAllocator<>>(this->pool_.options.chunk_size));
+                _allocator.Lend(*_pools.back(), _share);
+                _allocators.push_back(_pools.back().get());
+            }
+            std::vector<std::unique_ptr<rapidjson::Document>> _parts(_tasks.size());
+            std::atomic<bool> _failed{false};
+            parallel_for_(_threads, _tasks.size(), [&](std::size_t k, std::size_t t) {
+                if(_failed) return;
+                const ParallelNode& _node = _nodes[_tasks[k].first];
+                const auto& _piece = _node.pieces[_tasks[k].second];
+                _parts[k] = std::make_unique<rapidjson::Document>(_allocators[t]);
+                if(!parse_run_(buffer, _piece.begin, _piece.end, buffer[_node.open] == '{', *_parts[k])) _failed = true;
+            });
+            for(auto& _pool : _pools) _allocator.Absorb(*_pool);
+            if(_failed) return false;
+            // raw_key_ reads member names from buffer_, the old buffer stays alive in `buffer` meanwhile
+            this->buffer_.swap(buffer);
+            rapidjson::Value _root = stitch_(_nodes, _parts, _nodes.size() - 1, _allocator);
+            this->buffer_.swap(buffer);
+            static_cast<rapidjson::Value&>(_document) = _root;
+            this->document_.Swap(_document);
+            return true;
+        }
 
-namespace param {
-    namespace utils {
+        /**
+         * @brief FIFO of snapshots written by one lazily started worker, pending jobs for the same path coalesce.
+         * @details Snapshots are taken in request order by a second thread, so that a long write never
+         * delays the copy the caller waits for before modifying its document. A job is written once
+         * all snapshots requested for it are in.
+         */
+        class SaveQueue {
+        public:
+            //! fills the data pointers of the copied direct blocks and returns the snapshot, or nullptr on failure
+            using Take = std::function<std::unique_ptr<rapidjson::Document>(DirectData&)>;
 
-    template<typename T> struct is_bool : std::is_same<T, bool> {};
+            SaveQueue() = default;
+            SaveQueue(const SaveQueue&) = delete;
+            SaveQueue& operator = (const SaveQueue&) = delete;
+            ~SaveQueue() {
+                {
+                    std::lock_guard<std::mutex> lock(this->mutex_);
+                    this->stop_ = true;
+                }
+                this->copy_cv_.notify_all();
+                if(this->copier_.joinable()) this->copier_.join();
+                this->cv_.notify_all();
+                if(this->worker_.joinable()) this->worker_.join();
+            }
 
-    template<typename T> struct is_integral : std::integral_constant<bool, std::is_integral<T>::value && !is_bool<T>::value> {};
+            //! the last successful write, of the document at `generation`
+            struct Saved {
+                std::size_t generation{0};
+                std::string savepath;
+                bool compact{false};
+                int decimals{0};
+            };
 
-    template<typename T> using is_floating = std::is_floating_point<T>;
+            bool last_saved(Saved& saved) const {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                saved = this->saved_;
+                return saved.generation != 0;
+            }
 
-    template<typename T> struct is_real : std::integral_constant<bool, is_integral<T>::value || is_floating <T>::value> {};
+            std::size_t saved_generation() const { return this->saved_generation_.load(); }
 
-    template<typename T> struct is_complex : std::false_type {};
-    template<typename T> struct is_complex<std::complex<T>> : std::true_type {};
+            //! block until no job for `savepath` is pending or being written
+            void wait(const std::string& savepath) {
+                std::unique_lock<std::mutex> lock(this->mutex_);
+                this->idle_.wait(lock, [&]() {
+                    if(this->busy_ && this->running_ == savepath) return false;
+                    return std::none_of(this->jobs_.begin(), this->jobs_.end(), [&](const Job& job) { return job.savepath == savepath; });
+                });
+            }
 
-    template<typename T> struct is_c_string : std::integral_constant<bool, std::is_same<char const *, std::decay_t<T>>::value || std::is_same<char *, std::decay_t<T>>::value> {};
+            //! queue a write of the snapshot `take` will produce, `copied` becomes ready once it has
+            std::shared_future<bool> push(Take take, std::size_t generation, const std::string& savepath, bool compact, int decimals,
+                                          std::function<void(bool)> callback, std::shared_future<void>& copied) {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                auto _job = std::find_if(this->jobs_.begin(), this->jobs_.end(), [&](const Job& job) { return job.savepath == savepath; });
+                if(_job == this->jobs_.end()) {
+                    this->jobs_.emplace_back();
+                    _job = this->jobs_.end() - 1;
+                    _job->savepath = savepath;
+                    _job->future = _job->promise.get_future().share();
+                }
+                _job->compact = compact;
+                _job->decimals = decimals;
+                _job->copies++;
+                if(callback) _job->callbacks.emplace_back(std::move(callback));
+                this->copies_.emplace_back();
+                auto& _copy = this->copies_.back();
+                _copy.job = &*_job;
+                _copy.take = std::move(take);
+                _copy.generation = generation;
+                copied = _copy.copied.get_future().share();
+                if(!this->copier_.joinable()) this->copier_ = std::thread(&SaveQueue::copy_, this);
+                if(!this->worker_.joinable()) this->worker_ = std::thread(&SaveQueue::run_, this);
+                this->copy_cv_.notify_one();
+                return _job->future;
+            }
 
-    template<typename T> struct is_cpp_string : std::false_type {};
-    template<typename charT, typename traits, typename Alloc> struct is_cpp_string<std::basic_string<charT, traits, Alloc>> : std::true_type {};
+        private:
+            struct Job {
+                std::unique_ptr<rapidjson::Document> snapshot;
+                DirectData direct;
+                std::size_t generation{0};
+                std::string savepath;
+                bool compact{false};
+                int decimals{0};
+                std::size_t copies{0}; //!< snapshots still to be taken for this job
+                std::vector<std::function<void(bool)>> callbacks;
+                std::promise<bool> promise;
+                std::shared_future<bool> future;
+            };
 
-    template<typename T> struct is_string : std::integral_constant<bool, is_c_string<T>::value || is_cpp_string<T>::value> {};
+            //! a snapshot to take for `job`, which stays queued until then
+            struct Copy {
+                Job* job{nullptr};
+                Take take;
+                std::size_t generation{0};
+                std::promise<void> copied;
+            };
 
-    template<typename T> struct is_array : std::false_type {};
-    template<template<typename, typename> class C, typename T, typename Alloc> struct is_array<C<T, Alloc>> : std::true_type {};
+            void copy_() {
+                std::unique_lock<std::mutex> lock(this->mutex_);
+                while(true) {
+                    this->copy_cv_.wait(lock, [this]() { return this->stop_ || !this->copies_.empty(); });
+                    if(this->copies_.empty()) return;
+                    Copy _copy = std::move(this->copies_.front());
+                    this->copies_.pop_front();
+                    lock.unlock();
+                    DirectData _direct{};
+                    auto _snapshot = _copy.take(_direct);
+                    _copy.copied.set_value();
+                    lock.lock();
+                    // copies run in request order, so the newest snapshot of a coalesced job comes last
+                    _copy.job->snapshot = std::move(_snapshot);
+                    _copy.job->direct = std::move(_direct);
+                    _copy.job->generation = _copy.generation;
+                    _copy.job->copies--;
+                    this->cv_.notify_one();
+                }
+            }
 
-    }
-}
+            void run_() {
+                std::unique_lock<std::mutex> lock(this->mutex_);
+                while(true) {
+                    this->cv_.wait(lock, [this]() {
+                        return this->jobs_.empty() ? this->stop_ : this->jobs_.front().copies == 0;
+                    });
+                    if(this->jobs_.empty()) return;
+                    Job _job = std::move(this->jobs_.front());
+                    this->jobs_.pop_front();
+                    this->running_ = _job.savepath;
+                    this->busy_ = true;
+                    lock.unlock();
+                    // a missing snapshot is one whose sidecars could not be copied
+                    bool _ok = _job.snapshot && write_document_(*_job.snapshot, _job.savepath, _job.compact, _job.decimals, RawRange(nullptr, nullptr), _job.direct);
+                    _job.snapshot.reset();
+                    lock.lock();
+                    if(_ok) {
+                        this->saved_ = Saved{_job.generation, _job.savepath, _job.compact, std::max(_job.decimals, 0)};
+                        this->saved_generation_.store(_job.generation);
+                    }
+                    this->busy_ = false;
+                    this->idle_.notify_all();
+                    lock.unlock();
+                    _job.promise.set_value(_ok);
+                    for(auto& callback : _job.callbacks) callback(_ok);
+                    lock.lock();
+                }
+            }
 
-namespace param {
+            mutable std::mutex mutex_;
+            std::condition_variable cv_;
+            std::condition_variable copy_cv_;
+            std::condition_variable idle_;
+            std::deque<Job> jobs_;
+            std::deque<Copy> copies_;
+            std::string running_;
+            bool busy_{false};
+            Saved saved_;
+            std::atomic<std::size_t> saved_generation_{0};
+            std::thread copier_;
+            std::thread worker_;
+            bool stop_{false};
+        };
 
-    class ParaManager {
-    public:
-        ParaManager() = default;
-        ParaManager(const ParaManager&) = delete;
-        ParaManager& operator = (ParaManager&&) noexcept = default;
-        ~ParaManager() = default;
+        //! wait until save_async() has copied the document, before anything modifies it
+        void settle_snapshot_() {
+            if(!this->snapshot_copied_.valid()) return;
+            this->snapshot_copied_.wait();
+            this->snapshot_copied_ = std::shared_future<void>();
+        }
+
+        std::size_t count_keys_(const rapidjson::Value& value) const {
+            std::size_t n = 0;
+            if(is_raw_(value)) {
+                std::size_t _begin = static_cast<std::size_t>(value.GetString() - this->buffer_.data());
+                if(this->buffer_[_begin] != '{') return 1;
+                raw_items_(_begin, [&](std::size_t, std::size_t, std::size_t _value, std::size_t _end) {
+                    n += count_keys_(raw_value_(_value, _end));
+                });
+                return n;
+            }
+            if(!value.IsObject() || is_direct_(value)) return 1;
+            for(auto itr = value.MemberBegin(); itr != value.MemberEnd(); itr++) n += count_keys_(itr->value);
+            return n;
+        }
+
+        template<class F> void for_each_key_(const rapidjson::Value& value, std::string& path, F& callback) const {
+            if(is_raw_(value) && this->buffer_[static_cast<std::size_t>(value.GetString() - this->buffer_.data())] == '{') {
+                auto _length = path.size();
+                raw_items_(static_cast<std::size_t>(value.GetString() - this->buffer_.data()), [&](std::size_t _key, std::size_t _key_end, std::size_t _value, std::size_t _end) {
+                    raw_key_(_key, _key_end, [&](const char* _name, rapidjson::SizeType _length) { append_token_(path, _name, _length); });
+                    for_each_key_(raw_value_(_value, _end), path, callback);
+                    path.resize(_length);
+                });
+                return;
+            }
+            if(!value.IsObject() || is_direct_(value)) {
+                callback(static_cast<const std::string&>(path));
+                return;
+            }
+            auto _length = path.size();
+            for(auto itr = value.MemberBegin(); itr != value.MemberEnd(); itr++) {
+                append_token_(path, itr->name.GetString(), itr->name.GetStringLength());
+                for_each_key_(itr->value, path, callback);
+                path.resize(_length);
+            }
+        }
 
-        bool load(const std::string& filename) {
-            std::fstream ifs(filename);
+        static bool read_file_(const std::string& filename, std::vector<char>& buffer) {
+            std::ifstream ifs(filename, std::ios::binary);
             if(!ifs.good()) return false;
-            this->filename_ = filename;
-            rapidjson::IStreamWrapper isw(ifs);
-            document_.ParseStream(isw);
+            ifs.seekg(0, std::ios::end);
+            auto _size = static_cast<std::streamoff>(ifs.tellg());
+            if(_size < 0) return false;
+            ifs.seekg(0, std::ios::beg);
+            buffer.resize(static_cast<size_t>(_size) + 1);
+            ifs.read(buffer.data(), _size);
+            buffer.resize(static_cast<size_t>(ifs.gcount()) + 1);
+            buffer.back() = '\0';
             return true;
         }
 
-        void save(const std::string& filename = std::string()) {
-            std::string _savepath{};
-            if(filename.empty()) {
-                _savepath = this->filename_;
-            } else {
-                _savepath = filename;
+        rapidjson::Value* resolve_(const KeyHandle& key) {
+            if(!key.valid()) return nullptr;
+            if(key.owner_ != this) return find_layers_(key.pointer_, key.keypath_);
+            if(key.generation_ != this->generation_) {
+                key.value_ = find_layers_(key.pointer_, key.keypath_);
+                key.generation_ = this->generation_;
             }
-            std::ofstream ofs(_savepath);
-            rapidjson::OStreamWrapper osw(ofs);
-            rapidjson::PrettyWriter<rapidjson::OStreamWrapper> writer(osw);
-            writer.SetFormatOptions(rapidjson::kFormatSingleLineArray);
-            this->document_.Accept(writer);
+            return key.value_;
         }
 
-        bool erase(const std::string& keypath) {
-            return rapidjson::Pointer(keypath.c_str()).Erase(this->document_);
+        template<class T, std::enable_if_t<utils::is_cpp_string<T>::value, int> = 0>
+        T get_(rapidjson::Value* value_ptr, const T& default_value = T()) {
+            if(value_ptr == nullptr) return default_value;
+            if(value_ptr->IsString()) return T(value_ptr->GetString(), value_ptr->GetStringLength());
+            rapidjson::StringBuffer buf;
+            rapidjson::Writer<rapidjson::StringBuffer> writer(buf);
+            value_ptr->Accept(writer);
+            return T(buf.GetString(), buf.GetSize());
         }
 
-        std::vector<std::string> keys() {
-            std::vector<std::string> v{};
-            std::function<void(const rapidjson::Value&, const rapidjson::Pointer&)> dumpFunc =
-                    [&v, &dumpFunc](const rapidjson::Value& value, const rapidjson::Pointer& parent) -> void {
-                        if(value.IsObject()) {
-                            for(auto itr = value.MemberBegin(); itr != value.MemberEnd(); itr++) {
-                                dumpFunc(itr->value, parent.Append(itr->name.GetString(), itr->name.GetStringLength()));
-                            }
-                        } else {
-                            rapidjson::StringBuffer buf{};
-                            parent.Stringify(buf);
-                            v.emplace_back(buf.GetString());
-                        }
-                    };
-            rapidjson::Pointer root;
-            dumpFunc(this->document_, root);
-            return v;
+        //! view into document memory, valid until the value is modified or the document is reloaded
+        template<class T, std::enable_if_t<std::is_same<T, const char*>::value, int> = 0>
+        T get_(rapidjson::Value* value_ptr, const T& default_value = T()) {
+            if(value_ptr == nullptr) return default_value;
+            if(value_ptr->IsString()) return value_ptr->GetString(); else return default_value;
+        }
+
+        //! view into document memory, valid until the value is modified or the document is reloaded
+        template<class T, std::enable_if_t<utils::is_string_view<T>::value, int> = 0>
+        T get_(rapidjson::Value* value_ptr, const T& default_value = T()) {
+            if(value_ptr == nullptr) return default_value;
+            if(value_ptr->IsString()) return T(value_ptr->GetString(), value_ptr->GetStringLength()); else return default_value;
         }
 
-        template<class T, std::enable_if_t<!utils::is_array<T>::value, int> = 0> auto get(const std::string& keypath, const T& default_val = T()) {
-            auto _ptr = rapidjson::Pointer(keypath.c_str()).Get(this->document_);
-            return get_<T>(_ptr, default_val);
+        //! directory of `path` with its trailing slash, empty for the working directory
+        static std::string directory_of_(const std::string& path) {
+            auto _slash = path.find_last_of('/');
+            return _slash == std::string::npos ? std::string() : path.substr(0, _slash + 1);
         }
 
-        template<class T, class C = typename T::value_type, std::enable_if_t<utils::is_array<T>::value, int> = 0> auto get(const std::string& keypath, const T& default_val = T()) {
-            auto _ptr = rapidjson::Pointer(keypath.c_str()).Get(this->document_);
-            T value{};
-            if(_ptr->IsArray()) {
-                size_t _index = 0;
-                for(auto& item : _ptr->GetArray()) {
-                    if(!item.IsNull()) {
-                        std::string _subpath(keypath);
-                        _subpath += "/" + std::to_string(_index++);
-                        value.emplace_back(get<C>(_subpath));
-                    }
+        std::string sidecar_path_(const std::string& name) const {
+            if(!name.empty() && name[0] == '/') return name;
+            return directory_of_(this->filename_) + name;
+        }
+
+        //! "<stem><keypath>.npy" with '/' turned into '.', after '%' and '.' are escaped so that no two keypaths share a file
+        std::string sidecar_name_(const std::string& keypath) const {
+            auto _slash = this->filename_.find_last_of('/');
+            std::string _name = this->filename_.substr(_slash == std::string::npos ? 0 : _slash + 1);
+            auto _dot = _name.find_last_of('.');
+            if(_dot != std::string::npos) _name.resize(_dot);
+            if(_name.empty()) _name = "mjson";
+            for(auto c : keypath) {
+                if(c == '%') _name += "%25";
+                else if(c == '.') _name += "%2E";
+                else _name += (c == '/') ? '.' : c;
+            }
+            return _name + ".npy";
+        }
+
+        /**
+         * @brief Copy the .npy sidecars the document refers to next to `savepath`, if that is another directory.
+         * @details References are relative to the json file, so the saved copy needs its own sidecars.
+         * Absolute references are left alone.
+         */
+        bool copy_sidecars_(const std::string& savepath) const {
+            const std::string _from = directory_of_(this->filename_), _to = directory_of_(savepath);
+            if(_from == _to) return true;
+            bool _ok = true;
+            auto _copy = [&](const char* name) {
+                if(_ok && name[0] != '/' && name[0] != '\0') _ok = utils::copy_file(_from + name, _to + name);
+            };
+            for_each_sidecar_(this->document_, _copy);
+            return _ok;
+        }
+
+        template<class F> void for_each_sidecar_(const rapidjson::Value& value, F& callback) const {
+            if(is_raw_(value)) {
+                // unparsed text of a lazy document is only parsed if it may hold a reference
+                static const char kKey[] = "\"$npy\"";
+                const char* _end = value.GetString() + value.GetStringLength();
+                if(std::search(value.GetString(), _end, kKey, kKey + sizeof(kKey) - 1) == _end) return;
+                rapidjson::Document _parsed{};
+                _parsed.Parse(value.GetString(), value.GetStringLength());
+                if(!_parsed.HasParseError()) for_each_sidecar_(_parsed, callback);
+            } else if(value.IsObject()) {
+                auto _file = value.FindMember("$npy");
+                if(_file != value.MemberEnd() && _file->value.IsString()) {
+                    callback(_file->value.GetString());
+                    return;
                 }
-                return value;
-            } else {
-                return default_val;
+                for(auto itr = value.MemberBegin(); itr != value.MemberEnd(); itr++) for_each_sidecar_(itr->value, callback);
+            } else if(value.IsArray()) {
+                for(auto itr = value.Begin(); itr != value.End(); itr++) for_each_sidecar_(*itr, callback);
             }
         }
 
-        template<class T, std::enable_if_t<!utils::is_array<T>::value, int> = 0> void set(const std::string& keypath, const T& value) {
-            rapidjson::Pointer(keypath.c_str()).Create(this->document_);
-            auto _ptr = rapidjson::Pointer(keypath.c_str()).Get(this->document_);
-            set_<T>(_ptr, value);
+        template<class T, std::enable_if_t<!utils::is_typed_array<T>::value, int> = 0>
+        bool set_npy_(const std::string& , rapidjson::Value* , const T& ) { return false; }
+
+        template<class T, std::enable_if_t<utils::is_typed_array<T>::value, int> = 0>
+        bool set_npy_(const std::string& keypath, rapidjson::Value* value_ptr, const T& value) {
+            if(this->npy_threshold_ == 0 || value_ptr == nullptr) return false;
+            std::vector<std::size_t> _shape{};
+            if(!utils::npy_shape(value, _shape, 0) || !utils::rank_matches<T>(_shape.size())) return false;
+            auto _count = std::accumulate(_shape.begin(), _shape.end(), std::size_t(1), std::multiplies<std::size_t>());
+            if(_count < this->npy_threshold_) return false;
+            auto _name = sidecar_name_(keypath);
+            if(!utils::write_npy(sidecar_path_(_name), value, _shape)) return false;
+
+            auto& _allocator = this->document_.GetAllocator();
+            rapidjson::Value _dims(rapidjson::kArrayType);
+            _dims.Reserve(static_cast<rapidjson::SizeType>(_shape.size()), _allocator);
+            for(auto dim : _shape) _dims.PushBack(static_cast<uint64_t>(dim), _allocator);
+            value_ptr->SetObject();
+            value_ptr->AddMember("$npy", rapidjson::Value(_name.c_str(), static_cast<rapidjson::SizeType>(_name.size()), _allocator), _allocator);
+            value_ptr->AddMember("shape", _dims, _allocator);
+            value_ptr->AddMember("dtype", rapidjson::StringRef(utils::npy_storage<utils::scalar_of_t<T>>::dtype()), _allocator);
+            return true;
         }
 
-        template<class T, class C = typename T::value_type, std::enable_if_t<utils::is_array<T>::value, int> = 0> void set(const std::string& keypath, const T& value) {
-            size_t _index = 0;
-            for(auto& item: value) {
-                std::string _subpath(keypath);
-                _subpath += "/" + std::to_string(_index++);
-                set<C>(_subpath, item);
+        template<class T, std::enable_if_t<!utils::is_typed_array<T>::value, int> = 0>
+        bool set_b64_(rapidjson::Value* , const T& ) { return false; }
+
+        /**
+         * @brief Write a typed array as {"$dtype", "$shape", "$b64"}
+         * @details Ragged rank-2 arrays keep one object too, with "$lengths" listing the row sizes in place
+         * of "$shape" and the rows concatenated in "$b64".
+         */
+        template<class T, std::enable_if_t<utils::is_typed_array<T>::value, int> = 0>
+        bool set_b64_(rapidjson::Value* value_ptr, const T& value) {
+            using S = typename utils::npy_storage<utils::scalar_of_t<T>>::type;
+            std::vector<std::size_t> _shape{};
+            const bool _ragged = !utils::npy_shape(value, _shape, 0);
+            if(_ragged) {
+                if(!row_lengths_(value, _shape)) return false;
+            } else if(!utils::rank_matches<T>(_shape.size())) {
+                return false;
             }
+            std::vector<S> _data{};
+            _data.reserve(_ragged ? std::accumulate(_shape.begin(), _shape.end(), std::size_t(0))
+                                  : std::accumulate(_shape.begin(), _shape.end(), std::size_t(1), std::multiplies<std::size_t>()));
+            utils::npy_flatten<S>(value, _data);
+
+            auto& _allocator = this->document_.GetAllocator();
+            auto _length = utils::base64_encoded_size(_data.size() * sizeof(S));
+            auto* _text = static_cast<char*>(_allocator.Malloc(_length + 1));
+            utils::base64_encode(_data.data(), _data.size() * sizeof(S), _text);
+            _text[_length] = '\0';
+            rapidjson::Value _dims(rapidjson::kArrayType);
+            _dims.Reserve(static_cast<rapidjson::SizeType>(_shape.size()), _allocator);
+            for(auto dim : _shape) _dims.PushBack(static_cast<uint64_t>(dim), _allocator);
+            value_ptr->SetObject();
+            value_ptr->AddMember("$dtype", rapidjson::StringRef(utils::npy_storage<utils::scalar_of_t<T>>::dtype()), _allocator);
+            value_ptr->AddMember(rapidjson::StringRef(_ragged ? "$lengths" : "$shape"), _dims, _allocator);
+            value_ptr->AddMember("$b64", rapidjson::StringRef(_text, static_cast<rapidjson::SizeType>(_length)), _allocator);
+            return true;
         }
 
-    protected:
-        template<class T, std::enable_if_t<utils::is_string<T>::value, int> = 0>
+        //! row sizes of a ragged rank-2 array, false for any other rank
+        template<class T, std::enable_if_t<!utils::is_array<T>::value || utils::rank<T>::value != 2, int> = 0>
+        static bool row_lengths_(const T& , std::vector<std::size_t>& ) { return false; }
+
+        template<class T, std::enable_if_t<utils::is_array<T>::value && utils::rank<T>::value == 2, int> = 0>
+        static bool row_lengths_(const T& value, std::vector<std::size_t>& lengths) {
+            lengths.clear();
+            lengths.reserve(value.size());
+            for(const auto& row : value) lengths.push_back(row.size());
+            return true;
+        }
+
+        template<class T, std::enable_if_t<!utils::npy_storage<utils::scalar_of_t<T>>::value, int> = 0>
+        T get_typed_(rapidjson::Value* , const T& default_value) { return default_value; }
+
+        //! decode a .npy sidecar reference or a base64 typed array
+        template<class T, std::enable_if_t<utils::npy_storage<utils::scalar_of_t<T>>::value, int> = 0>
+        T get_typed_(rapidjson::Value* value_ptr, const T& default_value) {
+            auto _raw = is_direct_(*value_ptr) ? value_ptr->MemberBegin() : value_ptr->MemberEnd();
+            auto _file = value_ptr->FindMember("$npy");
+            if(_file != value_ptr->MemberEnd() && _file->value.IsString()) {
+                utils::mapped_file _map(sidecar_path_(_file->value.GetString()));
+                utils::npy_header _header{};
+                if(!_map.good() || !utils::read_npy_header(_map.data(), _map.size(), _header)) return default_value;
+                return get_typed_data_<T>(_header.dtype, _header.shape, _map.data() + _header.offset, _map.size() - _header.offset, default_value);
+            }
+            auto _b64 = _raw != value_ptr->MemberEnd() ? _raw : value_ptr->FindMember("$b64");
+            auto _dtype = value_ptr->FindMember("$dtype");
+            auto _shape = value_ptr->FindMember("$shape");
+            // ragged rank-2 arrays list their row sizes instead
+            const bool _ragged = _shape == value_ptr->MemberEnd();
+            if(_ragged) _shape = value_ptr->FindMember("$lengths");
+            if(_b64 == value_ptr->MemberEnd() || _dtype == value_ptr->MemberEnd() || _shape == value_ptr->MemberEnd()) return default_value;
+            if(!_b64->value.IsString() || !_dtype->value.IsString() || !_shape->value.IsArray()) return default_value;
+            if(_ragged && (!utils::is_array<T>::value || utils::rank<T>::value != 2)) return default_value;
+            std::vector<std::size_t> _dims{};
+            for(auto& dim : _shape->value.GetArray()) {
+                if(!dim.IsUint64()) return default_value;
+                _dims.push_back(static_cast<std::size_t>(dim.GetUint64()));
+            }
+            if(_b64 == _raw) return get_typed_data_<T>(_dtype->value.GetString(), _dims, _raw->value.GetString(), _raw->value.GetStringLength(), default_value, _ragged);
+            std::vector<char> _data{};
+            if(!utils::base64_decode(_b64->value.GetString(), _b64->value.GetStringLength(), _data)) return default_value;
+            return get_typed_data_<T>(_dtype->value.GetString(), _dims, _data.data(), _data.size(), default_value, _ragged);
+        }
+
+        //! `shape` holds the row lengths of a rank-2 array when `ragged`
+        template<class T>
+        T get_typed_data_(const std::string& dtype, const std::vector<std::size_t>& shape, const char* data, std::size_t size, const T& default_value,
+                          bool ragged = false) {
+            if(!ragged && !utils::rank_matches<T>(shape.size())) return default_value;
+            if(dtype == "f8") return get_typed_data_<T, double>(shape, data, size, default_value, ragged);
+            if(dtype == "f4") return get_typed_data_<T, float>(shape, data, size, default_value, ragged);
+            if(dtype == "i8") return get_typed_data_<T, std::int64_t>(shape, data, size, default_value, ragged);
+            if(dtype == "i4") return get_typed_data_<T, std::int32_t>(shape, data, size, default_value, ragged);
+            if(dtype == "c16") return get_typed_data_<T, std::complex<double>>(shape, data, size, default_value, ragged);
+            if(dtype == "c8") return get_typed_data_<T, std::complex<float>>(shape, data, size, default_value, ragged);
+            return default_value;
+        }
+
+        template<class T, class S, std::enable_if_t<!utils::npy_convertible<utils::scalar_of_t<T>, S>::value, int> = 0>
+        T get_typed_data_(const std::vector<std::size_t>& , const char* , std::size_t , const T& default_value, bool ) { return default_value; }
+
+        template<class T, class S, std::enable_if_t<utils::npy_convertible<utils::scalar_of_t<T>, S>::value, int> = 0>
+        T get_typed_data_(const std::vector<std::size_t>& shape, const char* data, std::size_t size, const T& default_value, bool ragged) {
+            auto _count = ragged ? std::accumulate(shape.begin(), shape.end(), std::size_t(0))
+                                 : std::accumulate(shape.begin(), shape.end(), std::size_t(1), std::multiplies<std::size_t>());
+            if(_count > size / sizeof(S)) return default_value;
+            if(ragged) return utils::npy_decode_rows<T, S>(data, shape);
+            return utils::npy_decode<T, S>(data, shape, 0);
+        }
+
+        template<class T, std::enable_if_t<converter<T>::value, int> = 0>
         T get_(rapidjson::Value* value_ptr, const T& default_value = T()) {
-            if(value_ptr == nullptr) return default_value;
-            rapidjson::StringBuffer buf;
-            rapidjson::Writer<rapidjson::StringBuffer> writer(buf);
-            value_ptr->Accept(writer);
-            std::string str = buf.GetString();
-            str.erase(std::remove(str.begin(), str.end(), '\"'), str.end());
-            return static_cast<T>(str);
+            return converter<T>::get(*this, value_ptr, default_value);
         }
 
         template<class T, std::enable_if_t<utils::is_bool<T>::value, int> = 0>
@@ -178,17 +2886,166 @@ namespace param {
         }
 
         template<class T, std::enable_if_t<utils::is_complex<T>::value, int> = 0>
+        T get_(rapidjson::Value* value_ptr, const T& default_value = T()) {
+            using R = typename T::value_type;
+            if(value_ptr == nullptr) return default_value;
+            if(value_ptr->IsString()) {
+                T value{};
+                if(utils::parse_complex(value_ptr->GetString(), value)) return value; else return default_value;
+            }
+            if(value_ptr->IsNumber()) return T(static_cast<R>(value_ptr->GetDouble()), R());
+            if(value_ptr->IsArray() && value_ptr->Size() == 2 && (*value_ptr)[0].IsNumber() && (*value_ptr)[1].IsNumber()) {
+                return T(static_cast<R>((*value_ptr)[0].GetDouble()), static_cast<R>((*value_ptr)[1].GetDouble()));
+            }
+            if(value_ptr->IsObject()) {
+                auto _re = value_ptr->FindMember("re");
+                auto _im = value_ptr->FindMember("im");
+                if(_re != value_ptr->MemberEnd() && _im != value_ptr->MemberEnd() && _re->value.IsNumber() && _im->value.IsNumber()) {
+                    return T(static_cast<R>(_re->value.GetDouble()), static_cast<R>(_im->value.GetDouble()));
+                }
+            }
+            return default_value;
+        }
+
+        template<class T, class C = typename T::value_type, std::enable_if_t<utils::is_array<T>::value, int> = 0>
         T get_(rapidjson::Value* value_ptr, const T& default_value = T()) {
             if(value_ptr == nullptr) return default_value;
-            auto _str = get_<std::string>(value_ptr);
-            std::istringstream iss(_str);
-            if(iss.good()) { T value{}; iss >> value; return static_cast<T>(value); } else return default_value;
+            if(value_ptr->IsObject()) return get_typed_<T>(value_ptr, default_value);
+            if(!value_ptr->IsArray()) return default_value;
+            T value{};
+            utils::reserve(value, value_ptr->Size());
+            for(auto& item : value_ptr->GetArray()) {
+                if(!item.IsNull()) value.emplace_back(get_<C>(&item));
+            }
+            return value;
         }
 
-        template<class T, std::enable_if_t<utils::is_array<T>::value, int> = 0>
-        T get_(rapidjson::Value* , const T& default_value = T()) { return default_value; }
+        template<class T, std::enable_if_t<utils::is_fixed_array<T>::value && !std::is_array<T>::value, int> = 0>
+        T get_(rapidjson::Value* value_ptr, const T& default_value = T()) {
+            T value{};
+            if(get_fixed_(value_ptr, value)) return value; else return default_value;
+        }
 
-        template<class T, std::enable_if_t<utils::is_cpp_string<T>::value, int> = 0>
+        //! decode an array of compile-time extent without allocation, unrolled for short extents
+        template<class T, std::enable_if_t<utils::is_fixed_array<T>::value, int> = 0>
+        bool get_fixed_(rapidjson::Value* value_ptr, T& value) {
+            constexpr std::size_t N = utils::fixed_extent<T>::value;
+            if(value_ptr == nullptr || !value_ptr->IsArray() || value_ptr->Size() != N) return false;
+            return get_fixed_items_(value_ptr->Begin(), value, std::integral_constant<bool, (N <= 16)>(), std::make_index_sequence<(N <= 16) ? N : 0>());
+        }
+
+        template<class T, std::size_t... I>
+        bool get_fixed_items_(rapidjson::Value* items, T& value, std::true_type, std::index_sequence<I...>) {
+            bool _ok = true;
+            int _unroll[] = {0, (_ok = get_fixed_item_(items + I, value[I]) && _ok, 0)...};
+            (void)_unroll;
+            (void)items;
+            return _ok;
+        }
+
+        template<class T>
+        bool get_fixed_items_(rapidjson::Value* items, T& value, std::false_type, std::index_sequence<>) {
+            for(std::size_t i = 0; i < utils::fixed_extent<T>::value; i++) {
+                if(!get_fixed_item_(items + i, value[i])) return false;
+            }
+            return true;
+        }
+
+        template<class C, std::enable_if_t<utils::is_fixed_array<C>::value, int> = 0>
+        bool get_fixed_item_(rapidjson::Value* item, C& value) { return get_fixed_(item, value); }
+
+        template<class C, std::enable_if_t<!utils::is_fixed_array<C>::value, int> = 0>
+        bool get_fixed_item_(rapidjson::Value* item, C& value) { value = get_<C>(item); return true; }
+
+        template<class T, class C = typename utils::fixed_extent<T>::value_type, std::enable_if_t<utils::is_fixed_array<T>::value, int> = 0>
+        void set_(rapidjson::Value* value_ptr, const T& value) {
+            if(value_ptr == nullptr) return;
+            constexpr auto N = static_cast<rapidjson::SizeType>(utils::fixed_extent<T>::value);
+            auto& _allocator = this->document_.GetAllocator();
+            if(!value_ptr->IsArray()) value_ptr->SetArray();
+            if(value_ptr->Size() > N) value_ptr->Erase(value_ptr->Begin() + N, value_ptr->End());
+            value_ptr->Reserve(N, _allocator);
+            while(value_ptr->Size() < N) value_ptr->PushBack(rapidjson::Value(), _allocator);
+            for(rapidjson::SizeType i = 0; i < N; i++) set_<C>(&(*value_ptr)[i], value[i]);
+        }
+
+        template<class T, std::enable_if_t<utils::is_ndarray<T>::value, int> = 0>
+        T get_(rapidjson::Value* value_ptr, const T& default_value = T()) {
+            if(value_ptr == nullptr) return default_value;
+            if(value_ptr->IsObject()) return get_typed_<T>(value_ptr, default_value);
+            if(!value_ptr->IsArray()) return default_value;
+            std::vector<std::size_t> _shape{};
+            for(auto _probe = value_ptr; _probe->IsArray(); _probe = _probe->Begin()) {
+                if(_probe != value_ptr && is_pair_element_<typename T::value_type>(*_probe)) break;
+                _shape.push_back(_probe->Size());
+                if(_probe->Empty()) break;
+            }
+            T value(_shape);
+            auto _cursor = value.data();
+            if(get_ndarray_(value_ptr, _shape, 0, _cursor)) return value; else return default_value;
+        }
+
+        //! whether `value` is a complex number in ComplexFormat::Pair rather than a dimension
+        template<class C> static bool is_pair_element_(const rapidjson::Value& value) {
+            return utils::is_complex<C>::value && value.IsArray() && value.Size() == 2 && value[0].IsNumber() && value[1].IsNumber();
+        }
+
+        //! fill row-major elements in one walk, false when the nested arrays are ragged
+        template<class C>
+        bool get_ndarray_(rapidjson::Value* value_ptr, const std::vector<std::size_t>& shape, std::size_t depth, C*& cursor) {
+            if(depth == shape.size()) {
+                if(value_ptr->IsArray() && !is_pair_element_<C>(*value_ptr)) return false;
+                *cursor++ = get_<C>(value_ptr);
+                return true;
+            }
+            if(!value_ptr->IsArray() || value_ptr->Size() != shape[depth]) return false;
+            for(auto& item : value_ptr->GetArray()) {
+                if(!get_ndarray_(&item, shape, depth + 1, cursor)) return false;
+            }
+            return true;
+        }
+
+        template<class T, std::enable_if_t<utils::is_ndarray<T>::value, int> = 0>
+        void set_(rapidjson::Value* value_ptr, const T& value) {
+            if(value_ptr == nullptr) return;
+            if(this->array_format_ == ArrayFormat::Base64 && set_b64_<T>(value_ptr, value)) return;
+            auto _cursor = value.data();
+            set_ndarray_(value_ptr, value.shape(), 0, _cursor);
+        }
+
+        template<class C>
+        void set_ndarray_(rapidjson::Value* value_ptr, const std::vector<std::size_t>& shape, std::size_t depth, const C*& cursor) {
+            if(depth == shape.size()) {
+                set_<C>(value_ptr, *cursor++);
+                return;
+            }
+            auto& _allocator = this->document_.GetAllocator();
+            auto _size = static_cast<rapidjson::SizeType>(shape[depth]);
+            if(!value_ptr->IsArray()) value_ptr->SetArray();
+            if(value_ptr->Size() > _size) value_ptr->Erase(value_ptr->Begin() + _size, value_ptr->End());
+            value_ptr->Reserve(_size, _allocator);
+            while(value_ptr->Size() < _size) value_ptr->PushBack(rapidjson::Value(), _allocator);
+            for(auto& item : value_ptr->GetArray()) set_ndarray_(&item, shape, depth + 1, cursor);
+        }
+
+        //! rewrite the array in place with exact size, reusing existing elements and their storage
+        template<class T, class C = typename T::value_type, std::enable_if_t<utils::is_array<T>::value, int> = 0>
+        void set_(rapidjson::Value* value_ptr, const T& value) {
+            if(value_ptr == nullptr) return;
+            if(this->array_format_ == ArrayFormat::Base64 && set_b64_<T>(value_ptr, value)) return;
+            auto& _allocator = this->document_.GetAllocator();
+            auto _size = static_cast<rapidjson::SizeType>(value.size());
+            if(!value_ptr->IsArray()) value_ptr->SetArray();
+            if(value_ptr->Size() > _size) value_ptr->Erase(value_ptr->Begin() + _size, value_ptr->End());
+            value_ptr->Reserve(_size, _allocator);
+            rapidjson::SizeType _index = 0;
+            for(const auto& item : value) {
+                if(_index == value_ptr->Size()) value_ptr->PushBack(rapidjson::Value(), _allocator);
+                set_<C>(&(*value_ptr)[_index++], item);
+            }
+        }
+
+        template<class T, std::enable_if_t<utils::is_cpp_string<T>::value || utils::is_string_view<T>::value, int> = 0>
         void set_(rapidjson::Value* value_ptr, const T& value) {
             if (value_ptr == nullptr) return;
             value_ptr->SetString(value.data(), value.size(), this->document_.GetAllocator());
@@ -201,6 +3058,12 @@ namespace param {
         }
 
 
+        template<class T, std::enable_if_t<converter<T>::value, int> = 0>
+        void set_(rapidjson::Value* value_ptr, const T& value) {
+            if(value_ptr == nullptr) return;
+            converter<T>::set(*this, value_ptr, value);
+        }
+
         template<class T, std::enable_if_t<utils::is_bool<T>::value, int> = 0>
         void set_(rapidjson::Value* value_ptr, const T& value) {
             if(value_ptr == nullptr) return;
@@ -222,13 +3085,494 @@ namespace param {
         template<class T, std::enable_if_t<utils::is_complex<T>::value, int> = 0>
         void set_(rapidjson::Value* value_ptr, const T& value) {
             if(value_ptr == nullptr) return;
-            std::stringstream ss; ss << value;
-            set_<std::string>(value_ptr, ss.str());
+            auto& _allocator = this->document_.GetAllocator();
+            switch(this->complex_format_) {
+                case ComplexFormat::Pair:
+                    value_ptr->SetArray().Reserve(2, _allocator);
+                    value_ptr->PushBack(static_cast<double>(value.real()), _allocator);
+                    value_ptr->PushBack(static_cast<double>(value.imag()), _allocator);
+                    break;
+                case ComplexFormat::Object:
+                    value_ptr->SetObject();
+                    value_ptr->AddMember("re", static_cast<double>(value.real()), _allocator);
+                    value_ptr->AddMember("im", static_cast<double>(value.imag()), _allocator);
+                    break;
+                default:
+                    char buf[64];
+                    value_ptr->SetString(buf, static_cast<rapidjson::SizeType>(utils::format_complex(value, buf)), _allocator);
+                    break;
+            }
         }
 
     protected:
         std::string filename_;
         rapidjson::Document document_;
+        std::vector<char> buffer_;
+        std::size_t generation_{1};
+        ComplexFormat complex_format_{ComplexFormat::String};
+        std::size_t npy_threshold_{0};
+        ArrayFormat array_format_{ArrayFormat::Nested};
+        // per-document state, grouped so that operator= moves each group whole
+        //! keypaths of set_direct_arrays() and the flat blocks their arrays were parsed into
+        struct DirectState {
+            std::vector<std::string> keypaths;
+            std::deque<std::vector<std::uint64_t>> blocks;
+        };
+        //! set_lazy(), whether the document holds unparsed values, and the structural tape over buffer_
+        struct LazyState {
+            bool enabled{false};
+            bool loaded{false};
+            std::vector<std::pair<std::uint32_t, std::uint32_t>> tape;
+        };
+        //! the two document pools that load() alternates between, the live one holding document_
+        struct PoolState {
+            PoolOptions options;
+            std::array<std::unique_ptr<rapidjson::MemoryPoolAllocator<>>, 2> pools;
+            std::size_t live{0};
+            bool stale{false};       //!< options changed, the spare pool must not be reused
+        };
+        DirectState direct_;
+        LazyState lazy_;
+        bool parse_error_{false};
+        std::size_t parallel_{1};
+        std::size_t parallel_min_size_{std::size_t(1) << 20};
+        std::size_t stack_capacity_{0};
+        PoolState pool_;
+        std::unique_ptr<SaveQueue> save_queue_{std::make_unique<SaveQueue>()};
+        std::shared_future<void> snapshot_copied_;
+        std::size_t synced_generation_{0};
+        std::string synced_path_;
+        bool synced_compact_{false};
+        int synced_decimals_{0};
+        std::set<std::string> dirty_keys_;
+        //! lower layers of load_layers(), highest last, and the winning layer per keypath
+        struct LayerHit {
+            std::size_t generation{0};
+            std::size_t layer{std::string::npos};
+            rapidjson::Value* value{nullptr};
+        };
+        std::vector<std::unique_ptr<ParaManager>> layers_;
+        std::unordered_map<std::string, LayerHit> layer_hits_;
+    };
+
+    /**
+     * @brief Thread-safe ParaManager with shared-locked reads and exclusive writes.
+     * @details Any number of threads may call get/keys/for_each_key/save concurrently, they only
+     * block while a set/erase is running. load() parses into a side document without holding the
+     * lock and swaps it in under the exclusive lock, so readers see either the old or the new
+     * document and never a half-parsed one.
+     * A file that fails to parse is not swapped in and load() returns false.
+     * A KeyHandle caches its resolution and must be used by one thread at a time, compile one per thread.
+     * Views into document memory (const char*, std::string_view) are rejected since a concurrent
+     * writer could invalidate them.
+     */
+    class ConcurrentParaManager {
+    public:
+        using KeyHandle = ParaManager::KeyHandle;
+
+        ConcurrentParaManager() = default;
+        ConcurrentParaManager(const ConcurrentParaManager&) = delete;
+        ConcurrentParaManager& operator = (const ConcurrentParaManager&) = delete;
+        ~ConcurrentParaManager() { unwatch(); }
+
+        bool load(const std::string& filename, bool insitu = false) {
+            if(load_(filename, insitu, false) != Reload::Loaded) return false;
+            rewatch_();
+            return true;
+        }
+
+        /**
+         * @brief Reload the loaded file in the background whenever it is rewritten (Linux only).
+         * @details An inotify watch on the parent directory catches both in-place writes and
+         * editors that replace the file by rename. The file is resolved again on every change, so
+         * after load() of another file that one is watched. The inode and modification time of the
+         * file are recorded on every load() and save(), so the manager's own writes and events for a
+         * version already loaded are ignored.
+         * The new file is parsed on the watcher thread and swapped in under the exclusive lock, then
+         * `callback(true)` runs on the watcher thread. A document with unsaved changes is never
+         * replaced: the change on disk is reported as `callback(false)` and the document is kept, save
+         * or load() it to resolve the conflict.
+         * The callback must not call watch() or unwatch().
+         * @return false if nothing is loaded or the watch could not be set up
+         */
+        bool watch(std::function<void(bool)> callback = std::function<void(bool)>()) {
+#ifdef __linux__
+            unwatch();
+            std::string _filename{};
+            {
+                std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+                _filename = this->manager_.filename();
+            }
+            if(_filename.empty()) return false;
+            int _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if(_fd < 0) return false;
+            int _pipe[2];
+            int _wd = inotify_add_watch(_fd, directory_(_filename).c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if(_wd < 0 || pipe2(_pipe, O_CLOEXEC) != 0) {
+                close(_fd);
+                return false;
+            }
+            {
+                std::lock_guard<std::mutex> lock(this->watch_mutex_);
+                this->wake_fd_ = _pipe[1];
+                this->stopping_ = false;
+            }
+            this->watcher_ = std::thread([this, _fd, _wd, _wake = _pipe[0], _dir = directory_(_filename), callback]() mutable {
+                alignas(struct inotify_event) char buf[4096];
+                struct pollfd fds[2] = {{_fd, POLLIN, 0}, {_wake, POLLIN, 0}};
+                while(true) {
+                    if(poll(fds, 2, -1) < 0) {
+                        if(errno == EINTR) continue; else break;
+                    }
+                    // 0 stops the watcher, 1 means load() replaced the file, which may live elsewhere
+                    char _signal = 1;
+                    if(fds[1].revents != 0 && (read(_wake, &_signal, 1) <= 0 || _signal == 0)) break;
+                    std::string _filename{};
+                    bool _insitu = false;
+                    {
+                        std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+                        _filename = this->manager_.filename();
+                        _insitu = this->insitu_;
+                    }
+                    if(directory_(_filename) != _dir) {
+                        inotify_rm_watch(_fd, _wd);
+                        _dir = directory_(_filename);
+                        _wd = inotify_add_watch(_fd, _dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+                    }
+                    std::string _base = _filename.substr(_filename.find_last_of('/') + 1);
+                    bool _changed = false;
+                    ssize_t _len;
+                    while((_len = read(_fd, buf, sizeof(buf))) > 0) {
+                        for(char* p = buf; p < buf + _len; ) {
+                            auto* _event = reinterpret_cast<struct inotify_event*>(p);
+                            if(_event->len > 0 && _base == _event->name) _changed = true;
+                            p += sizeof(struct inotify_event) + _event->len;
+                        }
+                    }
+                    if(!_changed || !foreign_change_(_filename)) continue;
+                    Reload _reload = load_(_filename, _insitu, true);
+                    if(_reload != Reload::Failed && callback) callback(_reload == Reload::Loaded);
+                }
+                close(_fd);
+                close(_wake);
+            });
+            return true;
+#else
+            (void)callback;
+            return false;
+#endif //__linux__
+        }
+
+        void unwatch() {
+#ifdef __linux__
+            if(!this->watcher_.joinable()) return;
+            {
+                std::lock_guard<std::mutex> lock(this->watch_mutex_);
+                char c = 0;
+                if(write(this->wake_fd_, &c, 1) < 0) {}
+                this->stopping_ = true;
+            }
+            this->writes_done_.notify_all();
+            this->watcher_.join();
+            std::lock_guard<std::mutex> lock(this->watch_mutex_);
+            close(this->wake_fd_);
+            this->wake_fd_ = -1;
+#endif //__linux__
+        }
+
+        //! saves run alongside readers but not alongside each other, they share the clean-state bookkeeping
+        bool save(const std::string& filename = std::string(), bool compact = false, int decimals = 0) {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            std::lock_guard<std::mutex> save_lock(this->save_mutex_);
+            const std::string _savepath = filename.empty() ? this->manager_.filename() : filename;
+            Stamp _before = begin_write_(_savepath);
+            bool _ok = this->manager_.save(filename, compact, decimals);
+            end_write_(_savepath, _before, _ok);
+            return _ok;
+        }
+
+        //! the snapshot is taken in the background, the next writer waits for it under the exclusive lock
+        std::shared_future<bool> save_async(const std::string& filename = std::string(), bool compact = false, int decimals = 0,
+                                            std::function<void(bool)> callback = std::function<void(bool)>()) {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            std::lock_guard<std::mutex> save_lock(this->save_mutex_);
+            const std::string _savepath = filename.empty() ? this->manager_.filename() : filename;
+            Stamp _before = begin_write_(_savepath);
+            return this->manager_.save_async(filename, compact, decimals, [this, _savepath, _before, callback](bool ok) {
+                if(callback) callback(ok);
+                end_write_(_savepath, _before, ok);
+            });
+        }
+
+        std::string filename() const {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            return this->manager_.filename();
+        }
+
+        bool dirty() const {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            std::lock_guard<std::mutex> save_lock(this->save_mutex_);
+            return this->manager_.dirty();
+        }
+
+        bool erase(const std::string& keypath) {
+            std::unique_lock<std::shared_timed_mutex> lock(this->mutex_);
+            return this->manager_.erase(keypath);
+        }
+
+        bool erase(const KeyHandle& key) {
+            std::unique_lock<std::shared_timed_mutex> lock(this->mutex_);
+            return this->manager_.erase(key);
+        }
+
+        std::vector<std::string> keys() const {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            return this->manager_.keys();
+        }
+
+        //! the shared lock is held while visiting, the callback must not write to this manager
+        template<class F> void for_each_key(F&& callback) const {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            this->manager_.for_each_key(std::forward<F>(callback));
+        }
+
+        void set_complex_format(ComplexFormat format) {
+            std::unique_lock<std::shared_timed_mutex> lock(this->mutex_);
+            this->manager_.set_complex_format(format);
+        }
+
+        ComplexFormat complex_format() const {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            return this->manager_.complex_format();
+        }
+
+        void set_npy_threshold(std::size_t elements) {
+            std::unique_lock<std::shared_timed_mutex> lock(this->mutex_);
+            this->manager_.set_npy_threshold(elements);
+        }
+
+        std::size_t npy_threshold() const {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            return this->manager_.npy_threshold();
+        }
+
+        void set_array_format(ArrayFormat format) {
+            std::unique_lock<std::shared_timed_mutex> lock(this->mutex_);
+            this->manager_.set_array_format(format);
+        }
+
+        ArrayFormat array_format() const {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            return this->manager_.array_format();
+        }
+
+        //! takes effect on the next load()
+        void set_direct_arrays(const std::vector<std::string>& keypaths) {
+            std::unique_lock<std::shared_timed_mutex> lock(this->mutex_);
+            this->manager_.set_direct_arrays(keypaths);
+        }
+
+        std::vector<std::string> direct_arrays() const {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            return this->manager_.direct_arrays();
+        }
+
+        //! takes effect on the next load()
+        void set_parallel(std::size_t threads, std::size_t min_size = std::size_t(1) << 20) {
+            std::unique_lock<std::shared_timed_mutex> lock(this->mutex_);
+            this->manager_.set_parallel(threads, min_size);
+        }
+
+        std::size_t parallel() const {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            return this->manager_.parallel();
+        }
+
+        std::size_t parallel_min_size() const {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            return this->manager_.parallel_min_size();
+        }
+
+        //! takes effect on the next load()
+        void set_pool_options(const PoolOptions& options) {
+            std::unique_lock<std::shared_timed_mutex> lock(this->mutex_);
+            this->manager_.set_pool_options(options);
+        }
+
+        PoolOptions pool_options() const {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            return this->manager_.pool_options();
+        }
+
+        KeyHandle compile(const std::string& keypath) const {
+            return this->manager_.compile(keypath);
+        }
+
+        //! takes the exclusive lock instead when a block of set_direct_arrays() has to be expanded first
+        template<class T> T get(const std::string& keypath, const T& default_val = T()) {
+            static_assert(!utils::is_view<T>::value, "views into document memory are not thread-safe");
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            if(this->manager_.expands_direct_<T>(rapidjson::Pointer(keypath.c_str()))) {
+                lock.unlock();
+                std::unique_lock<std::shared_timed_mutex> unique_lock(this->mutex_);
+                return this->manager_.get<T>(keypath, default_val);
+            }
+            return this->manager_.get<T>(keypath, default_val);
+        }
+
+        template<class T> T get(const KeyHandle& key, const T& default_val = T()) {
+            static_assert(!utils::is_view<T>::value, "views into document memory are not thread-safe");
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            if(this->manager_.expands_direct_<T>(key)) {
+                lock.unlock();
+                std::unique_lock<std::shared_timed_mutex> unique_lock(this->mutex_);
+                return this->manager_.get<T>(key, default_val);
+            }
+            return this->manager_.get<T>(key, default_val);
+        }
+
+        //! does not touch the loaded document
+        template<class... Args> std::size_t extract(const std::string& filename, Args&&... args) {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex_);
+            return this->manager_.extract(filename, std::forward<Args>(args)...);
+        }
+
+        template<class T> void set(const std::string& keypath, const T& value) {
+            std::unique_lock<std::shared_timed_mutex> lock(this->mutex_);
+            this->manager_.set<T>(keypath, value);
+        }
+
+        template<class T> void set(const KeyHandle& key, const T& value) {
+            std::unique_lock<std::shared_timed_mutex> lock(this->mutex_);
+            this->manager_.set<T>(key, value);
+        }
+
+    protected:
+        enum class Reload { Loaded, Failed, Kept };
+
+        //! identity of a file version, a save() renames a new inode over the target
+        struct Stamp {
+            bool exists{false};
+            std::uint64_t device{0};
+            std::uint64_t inode{0};
+            std::int64_t size{0};
+            std::int64_t mtime{0};
+
+            bool operator == (const Stamp& other) const {
+                return this->exists == other.exists && this->device == other.device && this->inode == other.inode &&
+                       this->size == other.size && this->mtime == other.mtime;
+            }
+        };
+
+        static Stamp stamp_(const std::string& path) {
+            Stamp _stamp{};
+#ifdef MJSON_CPP_POSIX
+            struct stat _stat{};
+            if(path.empty() || ::stat(path.c_str(), &_stat) != 0) return _stamp;
+            _stamp.exists = true;
+            _stamp.device = static_cast<std::uint64_t>(_stat.st_dev);
+            _stamp.inode = static_cast<std::uint64_t>(_stat.st_ino);
+            _stamp.size = static_cast<std::int64_t>(_stat.st_size);
+#ifdef __linux__
+            _stamp.mtime = static_cast<std::int64_t>(_stat.st_mtim.tv_sec) * 1000000000 + _stat.st_mtim.tv_nsec;
+#else
+            _stamp.mtime = static_cast<std::int64_t>(_stat.st_mtime);
+#endif //__linux__
+#else
+            (void)path;
+#endif //MJSON_CPP_POSIX
+            return _stamp;
+        }
+
+        //! the directory watched for `filename`
+        static std::string directory_(const std::string& filename) {
+            std::string _dir = ParaManager::directory_of_(filename);
+            return _dir.empty() ? "." : _dir;
+        }
+
+        /**
+         * @brief Parse `filename` off-lock and swap it in.
+         * @details With `keep_dirty` the swap is skipped when the document has unsaved changes, which
+         * the watcher must not overwrite, and fails when another file was loaded meanwhile.
+         */
+        Reload load_(const std::string& filename, bool insitu, bool keep_dirty) {
+            ParaManager _next{};
+            {
+                // exclusive since the spare pool of the current document moves over to _next
+                std::unique_lock<std::shared_timed_mutex> lock(this->mutex_);
+                if(keep_dirty && this->manager_.filename() != filename) return Reload::Failed;
+                if(keep_dirty && this->manager_.dirty()) return Reload::Kept;
+                _next.inherit_pools_(this->manager_);
+                _next.set_complex_format(this->manager_.complex_format());
+                _next.set_npy_threshold(this->manager_.npy_threshold());
+                _next.set_array_format(this->manager_.array_format());
+                _next.set_direct_arrays(this->manager_.direct_arrays());
+                _next.set_parallel(this->manager_.parallel(), this->manager_.parallel_min_size());
+            }
+            // taken before reading, a change in between is only seen as one more change
+            Stamp _stamp = stamp_(filename);
+            if(!_next.load(filename, insitu) || _next.has_parse_error()) return Reload::Failed;
+            std::unique_lock<std::shared_timed_mutex> lock(this->mutex_);
+            if(keep_dirty && this->manager_.filename() != filename) return Reload::Failed;
+            if(keep_dirty && this->manager_.dirty()) return Reload::Kept;
+            this->manager_ = std::move(_next);
+            this->insitu_ = insitu;
+            lock.unlock();
+            std::lock_guard<std::mutex> watch_lock(this->watch_mutex_);
+            this->known_path_ = filename;
+            this->known_ = _stamp;
+            return Reload::Loaded;
+        }
+
+        //! tell the watcher that load() may have moved the document to another file
+        void rewatch_() {
+#ifdef __linux__
+            std::lock_guard<std::mutex> lock(this->watch_mutex_);
+            char c = 1;
+            if(this->wake_fd_ >= 0 && write(this->wake_fd_, &c, 1) < 0) {}
+#endif //__linux__
+        }
+
+        Stamp begin_write_(const std::string& savepath) {
+            std::lock_guard<std::mutex> lock(this->watch_mutex_);
+            this->writes_++;
+            return stamp_(savepath);
+        }
+
+        //! remember the version a save() left behind, a skipped save leaves the file and its stamp alone
+        void end_write_(const std::string& savepath, const Stamp& before, bool ok) {
+            std::lock_guard<std::mutex> lock(this->watch_mutex_);
+            Stamp _after = stamp_(savepath);
+            if(ok && _after.exists && !(_after == before)) {
+                this->known_path_ = savepath;
+                this->known_ = _after;
+            }
+            this->writes_--;
+            this->writes_done_.notify_all();
+        }
+
+        //! whether `filename` differs from the version last loaded or saved here, waits for saves in flight
+        bool foreign_change_(const std::string& filename) {
+            std::unique_lock<std::mutex> lock(this->watch_mutex_);
+            this->writes_done_.wait(lock, [this]() { return this->writes_ == 0 || this->stopping_; });
+            if(this->stopping_) return false;
+            return this->known_path_ != filename || !(stamp_(filename) == this->known_);
+        }
+
+        //! declared first so that it outlives manager_, whose pending save_async() callbacks report here
+        std::mutex watch_mutex_;
+        std::condition_variable writes_done_;
+        std::size_t writes_{0};
+        std::string known_path_;
+        Stamp known_;
+        bool stopping_{false};
+        int wake_fd_{-1};
+
+        ParaManager manager_;
+        mutable std::shared_timed_mutex mutex_;
+        mutable std::mutex save_mutex_;
+        bool insitu_{false};
+        std::thread watcher_;
     };
 
 }
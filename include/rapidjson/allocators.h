@@ -121,7 +121,7 @@ public:
         \param baseAllocator The allocator for allocating memory chunks.
     */
     MemoryPoolAllocator(size_t chunkSize = kDefaultChunkCapacity, BaseAllocator* baseAllocator = 0) : 
-        chunkHead_(0), chunk_capacity_(chunkSize), userBuffer_(0), baseAllocator_(baseAllocator), ownBaseAllocator_(0)
+        chunkHead_(0), spareHead_(0), chunk_capacity_(chunkSize), userBuffer_(0), baseAllocator_(baseAllocator), ownBaseAllocator_(0)
     {
     }
 
@@ -136,7 +136,7 @@ public:
         \param baseAllocator The allocator for allocating memory chunks.
     */
     MemoryPoolAllocator(void *buffer, size_t size, size_t chunkSize = kDefaultChunkCapacity, BaseAllocator* baseAllocator = 0) :
-        chunkHead_(0), chunk_capacity_(chunkSize), userBuffer_(buffer), baseAllocator_(baseAllocator), ownBaseAllocator_(0)
+        chunkHead_(0), spareHead_(0), chunk_capacity_(chunkSize), userBuffer_(buffer), baseAllocator_(baseAllocator), ownBaseAllocator_(0)
     {
         RAPIDJSON_ASSERT(buffer != 0);
         RAPIDJSON_ASSERT(size > sizeof(ChunkHeader));
@@ -156,22 +156,68 @@ public:
 
     //! Deallocates all memory chunks, excluding the user-supplied buffer.
     void Clear() {
+        Recycle();
+        while (spareHead_) {
+            ChunkHeader* next = spareHead_->next;
+            baseAllocator_->Free(spareHead_);
+            spareHead_ = next;
+        }
+    }
+
+    //! Releases all memory blocks but keeps the chunks for later allocations.
+    /*! Malloc() takes kept chunks before asking the base allocator for new ones, so refilling
+        the pool with a similar workload allocates nothing. Clear() deallocates them.
+    */
+    void Recycle() {
         while (chunkHead_ && chunkHead_ != userBuffer_) {
             ChunkHeader* next = chunkHead_->next;
-            baseAllocator_->Free(chunkHead_);
+            chunkHead_->size = 0;
+            chunkHead_->next = spareHead_;
+            spareHead_ = chunkHead_;
             chunkHead_ = next;
         }
         if (chunkHead_ && chunkHead_ == userBuffer_)
             chunkHead_->size = 0; // Clear user buffer
     }
 
-    //! Computes the total capacity of allocated memory chunks.
+    //! Takes over all memory chunks of another pool, leaving it empty.
+    /*! Blocks allocated from \c rhs stay valid and are released with this allocator, e.g. when
+        several threads build parts of one document in pools of their own.
+        \pre \c rhs has no user buffer.
+    */
+    void Absorb(MemoryPoolAllocator& rhs) {
+        RAPIDJSON_ASSERT(rhs.userBuffer_ == 0);
+        if (!rhs.chunkHead_ && !rhs.spareHead_)
+            return;
+        if (!baseAllocator_)
+            ownBaseAllocator_ = baseAllocator_ = RAPIDJSON_NEW(BaseAllocator)();
+        Splice(chunkHead_, rhs.chunkHead_); // in front, so that a user buffer stays last
+        Splice(spareHead_, rhs.spareHead_);
+    }
+
+    //! Moves chunks kept by Recycle() to the spare list of another pool, until \c size bytes were moved.
+    /*! Lets pools of several threads refill retained memory; Absorb() takes the chunks back,
+        together with everything \c rhs allocated in them.
+    */
+    void Lend(MemoryPoolAllocator& rhs, size_t size) {
+        for (size_t lent = 0; spareHead_ && lent < size; ) {
+            ChunkHeader* chunk = spareHead_;
+            spareHead_ = chunk->next;
+            chunk->next = rhs.spareHead_;
+            rhs.spareHead_ = chunk;
+            lent += chunk->capacity;
+        }
+    }
+
+    //! Computes the total capacity of allocated memory chunks, including the ones kept by Recycle().
     /*! \return total capacity in bytes.
     */
     size_t Capacity() const {
         size_t capacity = 0;
         for (ChunkHeader* c = chunkHead_; c != 0; c = c->next)
             capacity += c->capacity;
+        for (ChunkHeader* c = spareHead_; c != 0; c = c->next)
+            capacity += c->capacity;
         return capacity;
     }
 
@@ -248,6 +294,23 @@ private:
         \return true if success.
     */
     bool AddChunk(size_t capacity) {
+        // Best fit among recycled chunks, which Recycle() leaves in allocation order so that
+        // a repeated workload finds an exact match first.
+        ChunkHeader** best = 0;
+        for (ChunkHeader** c = &spareHead_; *c; c = &(*c)->next) {
+            if ((*c)->capacity >= capacity && (!best || (*c)->capacity < (*best)->capacity)) {
+                best = c;
+                if ((*c)->capacity == capacity)
+                    break;
+            }
+        }
+        if (best) {
+            ChunkHeader* chunk = *best;
+            *best = chunk->next;
+            chunk->next = chunkHead_;
+            chunkHead_ = chunk;
+            return true;
+        }
         if (!baseAllocator_)
             ownBaseAllocator_ = baseAllocator_ = RAPIDJSON_NEW(BaseAllocator)();
         if (ChunkHeader* chunk = reinterpret_cast<ChunkHeader*>(baseAllocator_->Malloc(RAPIDJSON_ALIGN(sizeof(ChunkHeader)) + capacity))) {
@@ -272,7 +335,20 @@ private:
         ChunkHeader *next;  //!< Next chunk in the linked list.
     };
 
+    //! Moves the chunk list \c from in front of \c to.
+    static void Splice(ChunkHeader*& to, ChunkHeader*& from) {
+        if (!from)
+            return;
+        ChunkHeader* tail = from;
+        while (tail->next)
+            tail = tail->next;
+        tail->next = to;
+        to = from;
+        from = 0;
+    }
+
     ChunkHeader *chunkHead_;    //!< Head of the chunk linked-list. Only the head chunk serves allocation.
+    ChunkHeader *spareHead_;    //!< Chunks released by Recycle(), oldest first.
     size_t chunk_capacity_;     //!< The minimum capacity of chunk when they are allocated.
     void *userBuffer_;          //!< User supplied buffer.
     BaseAllocator* baseAllocator_;  //!< base allocator for allocating memory chunks.
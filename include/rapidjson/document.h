@@ -48,6 +48,7 @@ RAPIDJSON_DIAG_OFF(effc++)
 
 #if RAPIDJSON_HAS_CXX11_RVALUE_REFS
 #include <utility> // std::move
+#include <atomic>  // member index state
 #endif
 
 RAPIDJSON_NAMESPACE_BEGIN
@@ -101,6 +102,26 @@ class GenericDocument;
 #define RAPIDJSON_VALUE_DEFAULT_ARRAY_CAPACITY 16
 #endif
 
+/*! \def RAPIDJSON_VALUE_MEMBER_INDEX_THRESHOLD
+    \ingroup RAPIDJSON_CONFIG
+    \brief Member capacity from which an object keeps a hash index of its members.
+
+    Objects whose member capacity reaches this value reserve an open-addressing table behind
+    their members. The table is built by the first FindMember() on the object, so parsing does
+    not pay for it, and from then on lookups take constant instead of linear time. Concurrent
+    const lookups are safe: one of them builds the table while the others scan linearly. Once
+    built, the table is updated by AddMember(), RemoveMember() and EraseMember(); renaming or
+    reordering members through iterators (e.g. std::sort) is not supported on such objects.
+    Define as 0 to disable. Requires C++11 (std::atomic), otherwise always disabled.
+*/
+#ifndef RAPIDJSON_VALUE_MEMBER_INDEX_THRESHOLD
+#define RAPIDJSON_VALUE_MEMBER_INDEX_THRESHOLD 32
+#endif
+#if !RAPIDJSON_HAS_CXX11_RVALUE_REFS
+#undef RAPIDJSON_VALUE_MEMBER_INDEX_THRESHOLD
+#define RAPIDJSON_VALUE_MEMBER_INDEX_THRESHOLD 0
+#endif
+
 //! Name-value pair in a JSON object value.
 /*!
     This class was internal to GenericValue. It used to be a inner struct.
@@ -732,7 +753,7 @@ public:
         switch (rhs.GetType()) {
         case kObjectType: {
                 SizeType count = rhs.data_.o.size;
-                Member* lm = reinterpret_cast<Member*>(allocator.Malloc(count * sizeof(Member)));
+                Member* lm = reinterpret_cast<Member*>(allocator.Malloc(MembersSize(count)));
                 const typename GenericValue<Encoding,SourceAllocator>::Member* rm = rhs.GetMembersPointer();
                 for (SizeType i = 0; i < count; i++) {
                     new (&lm[i].name) GenericValue(rm[i].name, allocator, copyConstStrings);
@@ -741,6 +762,7 @@ public:
                 data_.f.flags = kObjectFlag;
                 data_.o.size = data_.o.capacity = count;
                 SetMembersPointer(lm);
+                ResetMemberIndex();
             }
             break;
         case kArrayType: {
@@ -1257,8 +1279,9 @@ public:
     GenericValue& MemberReserve(SizeType newCapacity, Allocator &allocator) {
         RAPIDJSON_ASSERT(IsObject());
         if (newCapacity > data_.o.capacity) {
-            SetMembersPointer(reinterpret_cast<Member*>(allocator.Realloc(GetMembersPointer(), data_.o.capacity * sizeof(Member), newCapacity * sizeof(Member))));
+            SetMembersPointer(reinterpret_cast<Member*>(allocator.Realloc(GetMembersPointer(), MembersSize(data_.o.capacity), MembersSize(newCapacity))));
             data_.o.capacity = newCapacity;
+            ResetMemberIndex();
         }
         return *this;
     }
@@ -1327,12 +1350,15 @@ public:
         \note Earlier versions of Rapidjson returned a \c NULL pointer, in case
             the requested member doesn't exist. For consistency with e.g.
             \c std::map, this has been changed to MemberEnd() now.
-        \note Linear time complexity.
+        \note Linear time complexity, constant for objects holding a member index
+            (see \ref RAPIDJSON_VALUE_MEMBER_INDEX_THRESHOLD).
     */
     template <typename SourceAllocator>
     MemberIterator FindMember(const GenericValue<Encoding, SourceAllocator>& name) {
         RAPIDJSON_ASSERT(IsObject());
         RAPIDJSON_ASSERT(name.IsString());
+        if (HasMemberIndex(data_.o.capacity) && EnsureMemberIndex())
+            return FindIndexedMember(name);
         MemberIterator member = MemberBegin();
         for ( ; member != MemberEnd(); ++member)
             if (name.StringEqual(member->name))
@@ -1374,6 +1400,8 @@ public:
         members[o.size].name.RawAssign(name);
         members[o.size].value.RawAssign(value);
         o.size++;
+        if (HasMemberIndex(o.capacity) && IsMemberIndexBuilt())
+            IndexMember(o.size - 1);
         return *this;
     }
 
@@ -1510,6 +1538,7 @@ public:
         for (MemberIterator m = MemberBegin(); m != MemberEnd(); ++m)
             m->~Member();
         data_.o.size = 0;
+        ResetMemberIndex();
     }
 
     //! Remove a member in object by its name.
@@ -1555,6 +1584,11 @@ public:
         RAPIDJSON_ASSERT(m >= MemberBegin() && m < MemberEnd());
 
         MemberIterator last(GetMembersPointer() + (data_.o.size - 1));
+        if (HasMemberIndex(data_.o.capacity) && IsMemberIndexBuilt()) {
+            UnindexMember(FindMemberSlot(static_cast<SizeType>(m - MemberBegin())));
+            if (m != last)
+                *FindMemberSlot(data_.o.size - 1) = static_cast<SizeType>(m - MemberBegin()) + 1;
+        }
         if (data_.o.size > 1 && m != last)
             *m = *last; // Move the last one to this place
         else
@@ -1594,6 +1628,13 @@ public:
         RAPIDJSON_ASSERT(last <= MemberEnd());
 
         MemberIterator pos = MemberBegin() + (first - MemberBegin());
+        if (HasMemberIndex(data_.o.capacity) && IsMemberIndexBuilt()) {
+            // Touching more than half of the table costs as much as the rebuild the next lookup would do.
+            if (MemberEnd() - first <= static_cast<std::ptrdiff_t>(data_.o.size / 2))
+                ShiftMemberIndex(static_cast<SizeType>(first - MemberBegin()), static_cast<SizeType>(last - MemberBegin()));
+            else
+                ResetMemberIndex();
+        }
         for (MemberIterator itr = pos; itr != last; ++itr)
             itr->~Member();
         std::memmove(static_cast<void*>(&*pos), &*last, static_cast<size_t>(MemberEnd() - last) * sizeof(Member));
@@ -2126,13 +2167,164 @@ private:
     void SetObjectRaw(Member* members, SizeType count, Allocator& allocator) {
         data_.f.flags = kObjectFlag;
         if (count) {
-            Member* m = static_cast<Member*>(allocator.Malloc(count * sizeof(Member)));
+            Member* m = static_cast<Member*>(allocator.Malloc(MembersSize(count)));
             SetMembersPointer(m);
             std::memcpy(static_cast<void*>(m), members, count * sizeof(Member));
         }
         else
             SetMembersPointer(0);
         data_.o.size = data_.o.capacity = count;
+        ResetMemberIndex();
+    }
+
+    // Member index: for capacities from RAPIDJSON_VALUE_MEMBER_INDEX_THRESHOLD, the members are
+    // followed in the same block by a state word (kMemberIndexUnbuilt/Building/Built) and a
+    // linear-probing table of (member position + 1), 0 marking an empty slot. The table is only
+    // valid, and only maintained, once the state is kMemberIndexBuilt.
+    static bool HasMemberIndex(SizeType capacity) {
+#if RAPIDJSON_VALUE_MEMBER_INDEX_THRESHOLD > 0
+        return capacity >= RAPIDJSON_VALUE_MEMBER_INDEX_THRESHOLD;
+#else
+        (void)capacity;
+        return false;
+#endif
+    }
+
+    //! Number of slots, a power of two keeping the load factor at or below 2/3.
+    static SizeType MemberIndexSize(SizeType capacity) {
+        SizeType n = capacity + capacity / 2 - 1;
+        n |= n >> 1;
+        n |= n >> 2;
+        n |= n >> 4;
+        n |= n >> 8;
+        n |= n >> 16;
+        return n + 1;
+    }
+
+    static size_t MembersSize(SizeType capacity) {
+        size_t size = capacity * sizeof(Member);
+        if (HasMemberIndex(capacity))
+            size += (1 + MemberIndexSize(capacity)) * sizeof(SizeType);
+        return size;
+    }
+
+    SizeType* GetMemberIndex() const { return reinterpret_cast<SizeType*>(GetMembersPointer() + data_.o.capacity) + 1; }
+
+#if RAPIDJSON_VALUE_MEMBER_INDEX_THRESHOLD > 0
+    enum { kMemberIndexUnbuilt, kMemberIndexBuilding, kMemberIndexBuilt };
+
+    std::atomic<SizeType>& GetMemberIndexState() const {
+        RAPIDJSON_STATIC_ASSERT(sizeof(std::atomic<SizeType>) == sizeof(SizeType));
+        return *reinterpret_cast<std::atomic<SizeType>*>(GetMembersPointer() + data_.o.capacity);
+    }
+
+    //! Mark the table as not built yet, after the block was (re)allocated or emptied.
+    void ResetMemberIndex() {
+        if (HasMemberIndex(data_.o.capacity))
+            new (&GetMemberIndexState()) std::atomic<SizeType>(kMemberIndexUnbuilt);
+    }
+
+    //! Only for modifying operations, which have exclusive access to the value.
+    bool IsMemberIndexBuilt() const { return GetMemberIndexState().load(std::memory_order_relaxed) == kMemberIndexBuilt; }
+
+    //! Build the table on first use. Returns false while another thread is building it.
+    bool EnsureMemberIndex() {
+        std::atomic<SizeType>& state = GetMemberIndexState();
+        SizeType s = state.load(std::memory_order_acquire);
+        if (s == kMemberIndexBuilt)
+            return true;
+        if (s != kMemberIndexUnbuilt || !state.compare_exchange_strong(s, kMemberIndexBuilding, std::memory_order_relaxed))
+            return false;
+        SizeType* index = GetMemberIndex();
+        std::memset(index, 0, MemberIndexSize(data_.o.capacity) * sizeof(SizeType));
+        for (SizeType i = 0; i < data_.o.size; i++)
+            IndexMember(i);
+        state.store(kMemberIndexBuilt, std::memory_order_release);
+        return true;
+    }
+#else
+    void ResetMemberIndex() {}
+    bool IsMemberIndexBuilt() const { return false; }
+    bool EnsureMemberIndex() { return false; }
+#endif
+
+    static SizeType HashName(const Ch* name, SizeType length) {
+        const char* p = reinterpret_cast<const char*>(name);
+        size_t n = length * sizeof(Ch);
+        uint64_t h = RAPIDJSON_UINT64_C2(0xcbf29ce4, 0x84222325) ^ n;
+        uint64_t w;
+        for (; n >= 8; p += 8, n -= 8) {
+            std::memcpy(&w, p, 8);
+            h = (h ^ w) * RAPIDJSON_UINT64_C2(0x9e3779b9, 0x7f4a7c15);
+            h ^= h >> 32;
+        }
+        w = 0;
+        for (size_t i = 0; i < n; i++)
+            w |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (i * 8);
+        h = (h ^ w) * RAPIDJSON_UINT64_C2(0x9e3779b9, 0x7f4a7c15);
+        h ^= h >> 29;
+        h *= RAPIDJSON_UINT64_C2(0xbf58476d, 0x1ce4e5b9);
+        return static_cast<SizeType>(h ^ (h >> 32));
+    }
+
+    SizeType HomeSlot(SizeType i, SizeType mask) const {
+        const Member& m = GetMembersPointer()[i];
+        return HashName(m.name.GetString(), m.name.GetStringLength()) & mask;
+    }
+
+    void IndexMember(SizeType i) {
+        SizeType* index = GetMemberIndex();
+        const SizeType mask = MemberIndexSize(data_.o.capacity) - 1;
+        SizeType slot = HomeSlot(i, mask);
+        while (index[slot])
+            slot = (slot + 1) & mask;
+        index[slot] = i + 1;
+    }
+
+    template <typename SourceAllocator>
+    MemberIterator FindIndexedMember(const GenericValue<Encoding, SourceAllocator>& name) {
+        const SizeType* index = GetMemberIndex();
+        const SizeType mask = MemberIndexSize(data_.o.capacity) - 1;
+        Member* members = GetMembersPointer();
+        for (SizeType slot = HashName(name.GetString(), name.GetStringLength()) & mask; index[slot]; slot = (slot + 1) & mask)
+            if (name.StringEqual(members[index[slot] - 1].name))
+                return MemberIterator(members + (index[slot] - 1));
+        return MemberEnd();
+    }
+
+    SizeType* FindMemberSlot(SizeType i) const {
+        SizeType* index = GetMemberIndex();
+        const SizeType mask = MemberIndexSize(data_.o.capacity) - 1;
+        SizeType slot = HomeSlot(i, mask);
+        while (index[slot] != i + 1)
+            slot = (slot + 1) & mask;
+        return index + slot;
+    }
+
+    //! Empty a slot, shifting back later entries of its probe run so lookups never stop early.
+    void UnindexMember(SizeType* slot) {
+        SizeType* index = GetMemberIndex();
+        const SizeType mask = MemberIndexSize(data_.o.capacity) - 1;
+        SizeType hole = static_cast<SizeType>(slot - index);
+        for (SizeType j = (hole + 1) & mask; index[j]; j = (j + 1) & mask) {
+            if (((j - HomeSlot(index[j] - 1, mask)) & mask) >= ((j - hole) & mask)) {
+                index[hole] = index[j];
+                hole = j;
+            }
+        }
+        index[hole] = 0;
+    }
+
+    //! Update the table for EraseMember(): drop the members in [first, last), renumber those after.
+    /*! Must run before the members are destroyed and moved, as slots are found by name.
+        Tail positions are renumbered in increasing order, so no entry ever equals the position
+        being looked up before that position itself is renumbered.
+    */
+    void ShiftMemberIndex(SizeType first, SizeType last) {
+        for (SizeType i = first; i < last; i++)
+            UnindexMember(FindMemberSlot(i));
+        for (SizeType i = last; i < data_.o.size; i++)
+            *FindMemberSlot(i) = i - (last - first) + 1;
     }
 
     //! Initialize this value as constant string, without calling destructor.
@@ -15,6 +15,9 @@
 // This is a C++ header-only implementation of Grisu2 algorithm from the publication:
 // Loitsch, Florian. "Printing floating-point numbers quickly and accurately with
 // integers." ACM Sigplan Notices 45.6 (2010): 233-243.
+//
+// dtoa() generates digits with Schubfach (below); define RAPIDJSON_DTOA_GRISU2 to
+// use Grisu2 instead, e.g. to compare the two.
 
 #ifndef RAPIDJSON_DTOA_
 #define RAPIDJSON_DTOA_
@@ -123,6 +126,753 @@ inline void Grisu2(double value, char* buffer, int* length, int* K) {
     DigitGen(W, Wp, Wp.f - Wm.f, buffer, length, K);
 }
 
+// Shortest round-trip digits by the Schubfach algorithm from the publication:
+// Giulietti, Raffaello. "The Schubfach way to render doubles." (2020).
+// Unlike Grisu2 it always yields the shortest (and closest) digits, and it needs
+// no digit-by-digit loop, so it is noticeably faster on full-precision values.
+
+//! g = floor(10^k * 2^(127 - floor(log2(10^k)))) + 1 as (hi, lo), k in [-292, 324]
+inline const uint64_t* GetSchubfachPow10(int k) {
+    static const uint64_t kPow10[] = {
+        RAPIDJSON_UINT64_C2(0xFF77B1FC, 0xBEBCDC4F), RAPIDJSON_UINT64_C2(0x25E8E89C, 0x13BB0F7B), // 1e-292
+        RAPIDJSON_UINT64_C2(0x9FAACF3D, 0xF73609B1), RAPIDJSON_UINT64_C2(0x77B19161, 0x8C54E9AD), // 1e-291
+        RAPIDJSON_UINT64_C2(0xC795830D, 0x75038C1D), RAPIDJSON_UINT64_C2(0xD59DF5B9, 0xEF6A2418), // 1e-290
+        RAPIDJSON_UINT64_C2(0xF97AE3D0, 0xD2446F25), RAPIDJSON_UINT64_C2(0x4B057328, 0x6B44AD1E), // 1e-289
+        RAPIDJSON_UINT64_C2(0x9BECCE62, 0x836AC577), RAPIDJSON_UINT64_C2(0x4EE367F9, 0x430AEC33), // 1e-288
+        RAPIDJSON_UINT64_C2(0xC2E801FB, 0x244576D5), RAPIDJSON_UINT64_C2(0x229C41F7, 0x93CDA740), // 1e-287
+        RAPIDJSON_UINT64_C2(0xF3A20279, 0xED56D48A), RAPIDJSON_UINT64_C2(0x6B435275, 0x78C11110), // 1e-286
+        RAPIDJSON_UINT64_C2(0x9845418C, 0x345644D6), RAPIDJSON_UINT64_C2(0x830A1389, 0x6B78AAAA), // 1e-285
+        RAPIDJSON_UINT64_C2(0xBE5691EF, 0x416BD60C), RAPIDJSON_UINT64_C2(0x23CC986B, 0xC656D554), // 1e-284
+        RAPIDJSON_UINT64_C2(0xEDEC366B, 0x11C6CB8F), RAPIDJSON_UINT64_C2(0x2CBFBE86, 0xB7EC8AA9), // 1e-283
+        RAPIDJSON_UINT64_C2(0x94B3A202, 0xEB1C3F39), RAPIDJSON_UINT64_C2(0x7BF7D714, 0x32F3D6AA), // 1e-282
+        RAPIDJSON_UINT64_C2(0xB9E08A83, 0xA5E34F07), RAPIDJSON_UINT64_C2(0xDAF5CCD9, 0x3FB0CC54), // 1e-281
+        RAPIDJSON_UINT64_C2(0xE858AD24, 0x8F5C22C9), RAPIDJSON_UINT64_C2(0xD1B3400F, 0x8F9CFF69), // 1e-280
+        RAPIDJSON_UINT64_C2(0x91376C36, 0xD99995BE), RAPIDJSON_UINT64_C2(0x23100809, 0xB9C21FA2), // 1e-279
+        RAPIDJSON_UINT64_C2(0xB5854744, 0x8FFFFB2D), RAPIDJSON_UINT64_C2(0xABD40A0C, 0x2832A78B), // 1e-278
+        RAPIDJSON_UINT64_C2(0xE2E69915, 0xB3FFF9F9), RAPIDJSON_UINT64_C2(0x16C90C8F, 0x323F516D), // 1e-277
+        RAPIDJSON_UINT64_C2(0x8DD01FAD, 0x907FFC3B), RAPIDJSON_UINT64_C2(0xAE3DA7D9, 0x7F6792E4), // 1e-276
+        RAPIDJSON_UINT64_C2(0xB1442798, 0xF49FFB4A), RAPIDJSON_UINT64_C2(0x99CD11CF, 0xDF41779D), // 1e-275
+        RAPIDJSON_UINT64_C2(0xDD95317F, 0x31C7FA1D), RAPIDJSON_UINT64_C2(0x40405643, 0xD711D584), // 1e-274
+        RAPIDJSON_UINT64_C2(0x8A7D3EEF, 0x7F1CFC52), RAPIDJSON_UINT64_C2(0x482835EA, 0x666B2573), // 1e-273
+        RAPIDJSON_UINT64_C2(0xAD1C8EAB, 0x5EE43B66), RAPIDJSON_UINT64_C2(0xDA324365, 0x0005EED0), // 1e-272
+        RAPIDJSON_UINT64_C2(0xD863B256, 0x369D4A40), RAPIDJSON_UINT64_C2(0x90BED43E, 0x40076A83), // 1e-271
+        RAPIDJSON_UINT64_C2(0x873E4F75, 0xE2224E68), RAPIDJSON_UINT64_C2(0x5A7744A6, 0xE804A292), // 1e-270
+        RAPIDJSON_UINT64_C2(0xA90DE353, 0x5AAAE202), RAPIDJSON_UINT64_C2(0x711515D0, 0xA205CB37), // 1e-269
+        RAPIDJSON_UINT64_C2(0xD3515C28, 0x31559A83), RAPIDJSON_UINT64_C2(0x0D5A5B44, 0xCA873E04), // 1e-268
+        RAPIDJSON_UINT64_C2(0x8412D999, 0x1ED58091), RAPIDJSON_UINT64_C2(0xE858790A, 0xFE9486C3), // 1e-267
+        RAPIDJSON_UINT64_C2(0xA5178FFF, 0x668AE0B6), RAPIDJSON_UINT64_C2(0x626E974D, 0xBE39A873), // 1e-266
+        RAPIDJSON_UINT64_C2(0xCE5D73FF, 0x402D98E3), RAPIDJSON_UINT64_C2(0xFB0A3D21, 0x2DC81290), // 1e-265
+        RAPIDJSON_UINT64_C2(0x80FA687F, 0x881C7F8E), RAPIDJSON_UINT64_C2(0x7CE66634, 0xBC9D0B9A), // 1e-264
+        RAPIDJSON_UINT64_C2(0xA139029F, 0x6A239F72), RAPIDJSON_UINT64_C2(0x1C1FFFC1, 0xEBC44E81), // 1e-263
+        RAPIDJSON_UINT64_C2(0xC9874347, 0x44AC874E), RAPIDJSON_UINT64_C2(0xA327FFB2, 0x66B56221), // 1e-262
+        RAPIDJSON_UINT64_C2(0xFBE91419, 0x15D7A922), RAPIDJSON_UINT64_C2(0x4BF1FF9F, 0x0062BAA9), // 1e-261
+        RAPIDJSON_UINT64_C2(0x9D71AC8F, 0xADA6C9B5), RAPIDJSON_UINT64_C2(0x6F773FC3, 0x603DB4AA), // 1e-260
+        RAPIDJSON_UINT64_C2(0xC4CE17B3, 0x99107C22), RAPIDJSON_UINT64_C2(0xCB550FB4, 0x384D21D4), // 1e-259
+        RAPIDJSON_UINT64_C2(0xF6019DA0, 0x7F549B2B), RAPIDJSON_UINT64_C2(0x7E2A53A1, 0x46606A49), // 1e-258
+        RAPIDJSON_UINT64_C2(0x99C10284, 0x4F94E0FB), RAPIDJSON_UINT64_C2(0x2EDA7444, 0xCBFC426E), // 1e-257
+        RAPIDJSON_UINT64_C2(0xC0314325, 0x637A1939), RAPIDJSON_UINT64_C2(0xFA911155, 0xFEFB5309), // 1e-256
+        RAPIDJSON_UINT64_C2(0xF03D93EE, 0xBC589F88), RAPIDJSON_UINT64_C2(0x793555AB, 0x7EBA27CB), // 1e-255
+        RAPIDJSON_UINT64_C2(0x96267C75, 0x35B763B5), RAPIDJSON_UINT64_C2(0x4BC1558B, 0x2F3458DF), // 1e-254
+        RAPIDJSON_UINT64_C2(0xBBB01B92, 0x83253CA2), RAPIDJSON_UINT64_C2(0x9EB1AAED, 0xFB016F17), // 1e-253
+        RAPIDJSON_UINT64_C2(0xEA9C2277, 0x23EE8BCB), RAPIDJSON_UINT64_C2(0x465E15A9, 0x79C1CADD), // 1e-252
+        RAPIDJSON_UINT64_C2(0x92A1958A, 0x7675175F), RAPIDJSON_UINT64_C2(0x0BFACD89, 0xEC191ECA), // 1e-251
+        RAPIDJSON_UINT64_C2(0xB749FAED, 0x14125D36), RAPIDJSON_UINT64_C2(0xCEF980EC, 0x671F667C), // 1e-250
+        RAPIDJSON_UINT64_C2(0xE51C79A8, 0x5916F484), RAPIDJSON_UINT64_C2(0x82B7E127, 0x80E7401B), // 1e-249
+        RAPIDJSON_UINT64_C2(0x8F31CC09, 0x37AE58D2), RAPIDJSON_UINT64_C2(0xD1B2ECB8, 0xB0908811), // 1e-248
+        RAPIDJSON_UINT64_C2(0xB2FE3F0B, 0x8599EF07), RAPIDJSON_UINT64_C2(0x861FA7E6, 0xDCB4AA16), // 1e-247
+        RAPIDJSON_UINT64_C2(0xDFBDCECE, 0x67006AC9), RAPIDJSON_UINT64_C2(0x67A791E0, 0x93E1D49B), // 1e-246
+        RAPIDJSON_UINT64_C2(0x8BD6A141, 0x006042BD), RAPIDJSON_UINT64_C2(0xE0C8BB2C, 0x5C6D24E1), // 1e-245
+        RAPIDJSON_UINT64_C2(0xAECC4991, 0x4078536D), RAPIDJSON_UINT64_C2(0x58FAE9F7, 0x73886E19), // 1e-244
+        RAPIDJSON_UINT64_C2(0xDA7F5BF5, 0x90966848), RAPIDJSON_UINT64_C2(0xAF39A475, 0x506A899F), // 1e-243
+        RAPIDJSON_UINT64_C2(0x888F9979, 0x7A5E012D), RAPIDJSON_UINT64_C2(0x6D8406C9, 0x52429604), // 1e-242
+        RAPIDJSON_UINT64_C2(0xAAB37FD7, 0xD8F58178), RAPIDJSON_UINT64_C2(0xC8E5087B, 0xA6D33B84), // 1e-241
+        RAPIDJSON_UINT64_C2(0xD5605FCD, 0xCF32E1D6), RAPIDJSON_UINT64_C2(0xFB1E4A9A, 0x90880A65), // 1e-240
+        RAPIDJSON_UINT64_C2(0x855C3BE0, 0xA17FCD26), RAPIDJSON_UINT64_C2(0x5CF2EEA0, 0x9A550680), // 1e-239
+        RAPIDJSON_UINT64_C2(0xA6B34AD8, 0xC9DFC06F), RAPIDJSON_UINT64_C2(0xF42FAA48, 0xC0EA481F), // 1e-238
+        RAPIDJSON_UINT64_C2(0xD0601D8E, 0xFC57B08B), RAPIDJSON_UINT64_C2(0xF13B94DA, 0xF124DA27), // 1e-237
+        RAPIDJSON_UINT64_C2(0x823C1279, 0x5DB6CE57), RAPIDJSON_UINT64_C2(0x76C53D08, 0xD6B70859), // 1e-236
+        RAPIDJSON_UINT64_C2(0xA2CB1717, 0xB52481ED), RAPIDJSON_UINT64_C2(0x54768C4B, 0x0C64CA6F), // 1e-235
+        RAPIDJSON_UINT64_C2(0xCB7DDCDD, 0xA26DA268), RAPIDJSON_UINT64_C2(0xA9942F5D, 0xCF7DFD0A), // 1e-234
+        RAPIDJSON_UINT64_C2(0xFE5D5415, 0x0B090B02), RAPIDJSON_UINT64_C2(0xD3F93B35, 0x435D7C4D), // 1e-233
+        RAPIDJSON_UINT64_C2(0x9EFA548D, 0x26E5A6E1), RAPIDJSON_UINT64_C2(0xC47BC501, 0x4A1A6DB0), // 1e-232
+        RAPIDJSON_UINT64_C2(0xC6B8E9B0, 0x709F109A), RAPIDJSON_UINT64_C2(0x359AB641, 0x9CA1091C), // 1e-231
+        RAPIDJSON_UINT64_C2(0xF867241C, 0x8CC6D4C0), RAPIDJSON_UINT64_C2(0xC30163D2, 0x03C94B63), // 1e-230
+        RAPIDJSON_UINT64_C2(0x9B407691, 0xD7FC44F8), RAPIDJSON_UINT64_C2(0x79E0DE63, 0x425DCF1E), // 1e-229
+        RAPIDJSON_UINT64_C2(0xC2109436, 0x4DFB5636), RAPIDJSON_UINT64_C2(0x985915FC, 0x12F542E5), // 1e-228
+        RAPIDJSON_UINT64_C2(0xF294B943, 0xE17A2BC4), RAPIDJSON_UINT64_C2(0x3E6F5B7B, 0x17B2939E), // 1e-227
+        RAPIDJSON_UINT64_C2(0x979CF3CA, 0x6CEC5B5A), RAPIDJSON_UINT64_C2(0xA705992C, 0xEECF9C43), // 1e-226
+        RAPIDJSON_UINT64_C2(0xBD8430BD, 0x08277231), RAPIDJSON_UINT64_C2(0x50C6FF78, 0x2A838354), // 1e-225
+        RAPIDJSON_UINT64_C2(0xECE53CEC, 0x4A314EBD), RAPIDJSON_UINT64_C2(0xA4F8BF56, 0x35246429), // 1e-224
+        RAPIDJSON_UINT64_C2(0x940F4613, 0xAE5ED136), RAPIDJSON_UINT64_C2(0x871B7795, 0xE136BE9A), // 1e-223
+        RAPIDJSON_UINT64_C2(0xB9131798, 0x99F68584), RAPIDJSON_UINT64_C2(0x28E2557B, 0x59846E40), // 1e-222
+        RAPIDJSON_UINT64_C2(0xE757DD7E, 0xC07426E5), RAPIDJSON_UINT64_C2(0x331AEADA, 0x2FE589D0), // 1e-221
+        RAPIDJSON_UINT64_C2(0x9096EA6F, 0x3848984F), RAPIDJSON_UINT64_C2(0x3FF0D2C8, 0x5DEF7622), // 1e-220
+        RAPIDJSON_UINT64_C2(0xB4BCA50B, 0x065ABE63), RAPIDJSON_UINT64_C2(0x0FED077A, 0x756B53AA), // 1e-219
+        RAPIDJSON_UINT64_C2(0xE1EBCE4D, 0xC7F16DFB), RAPIDJSON_UINT64_C2(0xD3E84959, 0x12C62895), // 1e-218
+        RAPIDJSON_UINT64_C2(0x8D3360F0, 0x9CF6E4BD), RAPIDJSON_UINT64_C2(0x64712DD7, 0xABBBD95D), // 1e-217
+        RAPIDJSON_UINT64_C2(0xB080392C, 0xC4349DEC), RAPIDJSON_UINT64_C2(0xBD8D794D, 0x96AACFB4), // 1e-216
+        RAPIDJSON_UINT64_C2(0xDCA04777, 0xF541C567), RAPIDJSON_UINT64_C2(0xECF0D7A0, 0xFC5583A1), // 1e-215
+        RAPIDJSON_UINT64_C2(0x89E42CAA, 0xF9491B60), RAPIDJSON_UINT64_C2(0xF41686C4, 0x9DB57245), // 1e-214
+        RAPIDJSON_UINT64_C2(0xAC5D37D5, 0xB79B6239), RAPIDJSON_UINT64_C2(0x311C2875, 0xC522CED6), // 1e-213
+        RAPIDJSON_UINT64_C2(0xD77485CB, 0x25823AC7), RAPIDJSON_UINT64_C2(0x7D633293, 0x366B828C), // 1e-212
+        RAPIDJSON_UINT64_C2(0x86A8D39E, 0xF77164BC), RAPIDJSON_UINT64_C2(0xAE5DFF9C, 0x02033198), // 1e-211
+        RAPIDJSON_UINT64_C2(0xA8530886, 0xB54DBDEB), RAPIDJSON_UINT64_C2(0xD9F57F83, 0x0283FDFD), // 1e-210
+        RAPIDJSON_UINT64_C2(0xD267CAA8, 0x62A12D66), RAPIDJSON_UINT64_C2(0xD072DF63, 0xC324FD7C), // 1e-209
+        RAPIDJSON_UINT64_C2(0x8380DEA9, 0x3DA4BC60), RAPIDJSON_UINT64_C2(0x4247CB9E, 0x59F71E6E), // 1e-208
+        RAPIDJSON_UINT64_C2(0xA4611653, 0x8D0DEB78), RAPIDJSON_UINT64_C2(0x52D9BE85, 0xF074E609), // 1e-207
+        RAPIDJSON_UINT64_C2(0xCD795BE8, 0x70516656), RAPIDJSON_UINT64_C2(0x67902E27, 0x6C921F8C), // 1e-206
+        RAPIDJSON_UINT64_C2(0x806BD971, 0x4632DFF6), RAPIDJSON_UINT64_C2(0x00BA1CD8, 0xA3DB53B7), // 1e-205
+        RAPIDJSON_UINT64_C2(0xA086CFCD, 0x97BF97F3), RAPIDJSON_UINT64_C2(0x80E8A40E, 0xCCD228A5), // 1e-204
+        RAPIDJSON_UINT64_C2(0xC8A883C0, 0xFDAF7DF0), RAPIDJSON_UINT64_C2(0x6122CD12, 0x8006B2CE), // 1e-203
+        RAPIDJSON_UINT64_C2(0xFAD2A4B1, 0x3D1B5D6C), RAPIDJSON_UINT64_C2(0x796B8057, 0x20085F82), // 1e-202
+        RAPIDJSON_UINT64_C2(0x9CC3A6EE, 0xC6311A63), RAPIDJSON_UINT64_C2(0xCBE33036, 0x74053BB1), // 1e-201
+        RAPIDJSON_UINT64_C2(0xC3F490AA, 0x77BD60FC), RAPIDJSON_UINT64_C2(0xBEDBFC44, 0x11068A9D), // 1e-200
+        RAPIDJSON_UINT64_C2(0xF4F1B4D5, 0x15ACB93B), RAPIDJSON_UINT64_C2(0xEE92FB55, 0x15482D45), // 1e-199
+        RAPIDJSON_UINT64_C2(0x99171105, 0x2D8BF3C5), RAPIDJSON_UINT64_C2(0x751BDD15, 0x2D4D1C4B), // 1e-198
+        RAPIDJSON_UINT64_C2(0xBF5CD546, 0x78EEF0B6), RAPIDJSON_UINT64_C2(0xD262D45A, 0x78A0635E), // 1e-197
+        RAPIDJSON_UINT64_C2(0xEF340A98, 0x172AACE4), RAPIDJSON_UINT64_C2(0x86FB8971, 0x16C87C35), // 1e-196
+        RAPIDJSON_UINT64_C2(0x9580869F, 0x0E7AAC0E), RAPIDJSON_UINT64_C2(0xD45D35E6, 0xAE3D4DA1), // 1e-195
+        RAPIDJSON_UINT64_C2(0xBAE0A846, 0xD2195712), RAPIDJSON_UINT64_C2(0x89748360, 0x59CCA10A), // 1e-194
+        RAPIDJSON_UINT64_C2(0xE998D258, 0x869FACD7), RAPIDJSON_UINT64_C2(0x2BD1A438, 0x703FC94C), // 1e-193
+        RAPIDJSON_UINT64_C2(0x91FF8377, 0x5423CC06), RAPIDJSON_UINT64_C2(0x7B6306A3, 0x4627DDD0), // 1e-192
+        RAPIDJSON_UINT64_C2(0xB67F6455, 0x292CBF08), RAPIDJSON_UINT64_C2(0x1A3BC84C, 0x17B1D543), // 1e-191
+        RAPIDJSON_UINT64_C2(0xE41F3D6A, 0x7377EECA), RAPIDJSON_UINT64_C2(0x20CABA5F, 0x1D9E4A94), // 1e-190
+        RAPIDJSON_UINT64_C2(0x8E938662, 0x882AF53E), RAPIDJSON_UINT64_C2(0x547EB47B, 0x7282EE9D), // 1e-189
+        RAPIDJSON_UINT64_C2(0xB23867FB, 0x2A35B28D), RAPIDJSON_UINT64_C2(0xE99E619A, 0x4F23AA44), // 1e-188
+        RAPIDJSON_UINT64_C2(0xDEC681F9, 0xF4C31F31), RAPIDJSON_UINT64_C2(0x6405FA00, 0xE2EC94D5), // 1e-187
+        RAPIDJSON_UINT64_C2(0x8B3C113C, 0x38F9F37E), RAPIDJSON_UINT64_C2(0xDE83BC40, 0x8DD3DD05), // 1e-186
+        RAPIDJSON_UINT64_C2(0xAE0B158B, 0x4738705E), RAPIDJSON_UINT64_C2(0x9624AB50, 0xB148D446), // 1e-185
+        RAPIDJSON_UINT64_C2(0xD98DDAEE, 0x19068C76), RAPIDJSON_UINT64_C2(0x3BADD624, 0xDD9B0958), // 1e-184
+        RAPIDJSON_UINT64_C2(0x87F8A8D4, 0xCFA417C9), RAPIDJSON_UINT64_C2(0xE54CA5D7, 0x0A80E5D7), // 1e-183
+        RAPIDJSON_UINT64_C2(0xA9F6D30A, 0x038D1DBC), RAPIDJSON_UINT64_C2(0x5E9FCF4C, 0xCD211F4D), // 1e-182
+        RAPIDJSON_UINT64_C2(0xD47487CC, 0x8470652B), RAPIDJSON_UINT64_C2(0x7647C320, 0x00696720), // 1e-181
+        RAPIDJSON_UINT64_C2(0x84C8D4DF, 0xD2C63F3B), RAPIDJSON_UINT64_C2(0x29ECD9F4, 0x0041E074), // 1e-180
+        RAPIDJSON_UINT64_C2(0xA5FB0A17, 0xC777CF09), RAPIDJSON_UINT64_C2(0xF4681071, 0x00525891), // 1e-179
+        RAPIDJSON_UINT64_C2(0xCF79CC9D, 0xB955C2CC), RAPIDJSON_UINT64_C2(0x7182148D, 0x4066EEB5), // 1e-178
+        RAPIDJSON_UINT64_C2(0x81AC1FE2, 0x93D599BF), RAPIDJSON_UINT64_C2(0xC6F14CD8, 0x48405531), // 1e-177
+        RAPIDJSON_UINT64_C2(0xA21727DB, 0x38CB002F), RAPIDJSON_UINT64_C2(0xB8ADA00E, 0x5A506A7D), // 1e-176
+        RAPIDJSON_UINT64_C2(0xCA9CF1D2, 0x06FDC03B), RAPIDJSON_UINT64_C2(0xA6D90811, 0xF0E4851D), // 1e-175
+        RAPIDJSON_UINT64_C2(0xFD442E46, 0x88BD304A), RAPIDJSON_UINT64_C2(0x908F4A16, 0x6D1DA664), // 1e-174
+        RAPIDJSON_UINT64_C2(0x9E4A9CEC, 0x15763E2E), RAPIDJSON_UINT64_C2(0x9A598E4E, 0x043287FF), // 1e-173
+        RAPIDJSON_UINT64_C2(0xC5DD4427, 0x1AD3CDBA), RAPIDJSON_UINT64_C2(0x40EFF1E1, 0x853F29FE), // 1e-172
+        RAPIDJSON_UINT64_C2(0xF7549530, 0xE188C128), RAPIDJSON_UINT64_C2(0xD12BEE59, 0xE68EF47D), // 1e-171
+        RAPIDJSON_UINT64_C2(0x9A94DD3E, 0x8CF578B9), RAPIDJSON_UINT64_C2(0x82BB74F8, 0x301958CF), // 1e-170
+        RAPIDJSON_UINT64_C2(0xC13A148E, 0x3032D6E7), RAPIDJSON_UINT64_C2(0xE36A5236, 0x3C1FAF02), // 1e-169
+        RAPIDJSON_UINT64_C2(0xF18899B1, 0xBC3F8CA1), RAPIDJSON_UINT64_C2(0xDC44E6C3, 0xCB279AC2), // 1e-168
+        RAPIDJSON_UINT64_C2(0x96F5600F, 0x15A7B7E5), RAPIDJSON_UINT64_C2(0x29AB103A, 0x5EF8C0BA), // 1e-167
+        RAPIDJSON_UINT64_C2(0xBCB2B812, 0xDB11A5DE), RAPIDJSON_UINT64_C2(0x7415D448, 0xF6B6F0E8), // 1e-166
+        RAPIDJSON_UINT64_C2(0xEBDF6617, 0x91D60F56), RAPIDJSON_UINT64_C2(0x111B495B, 0x3464AD22), // 1e-165
+        RAPIDJSON_UINT64_C2(0x936B9FCE, 0xBB25C995), RAPIDJSON_UINT64_C2(0xCAB10DD9, 0x00BEEC35), // 1e-164
+        RAPIDJSON_UINT64_C2(0xB84687C2, 0x69EF3BFB), RAPIDJSON_UINT64_C2(0x3D5D514F, 0x40EEA743), // 1e-163
+        RAPIDJSON_UINT64_C2(0xE65829B3, 0x046B0AFA), RAPIDJSON_UINT64_C2(0x0CB4A5A3, 0x112A5113), // 1e-162
+        RAPIDJSON_UINT64_C2(0x8FF71A0F, 0xE2C2E6DC), RAPIDJSON_UINT64_C2(0x47F0E785, 0xEABA72AC), // 1e-161
+        RAPIDJSON_UINT64_C2(0xB3F4E093, 0xDB73A093), RAPIDJSON_UINT64_C2(0x59ED2167, 0x65690F57), // 1e-160
+        RAPIDJSON_UINT64_C2(0xE0F218B8, 0xD25088B8), RAPIDJSON_UINT64_C2(0x306869C1, 0x3EC3532D), // 1e-159
+        RAPIDJSON_UINT64_C2(0x8C974F73, 0x83725573), RAPIDJSON_UINT64_C2(0x1E414218, 0xC73A13FC), // 1e-158
+        RAPIDJSON_UINT64_C2(0xAFBD2350, 0x644EEACF), RAPIDJSON_UINT64_C2(0xE5D1929E, 0xF90898FB), // 1e-157
+        RAPIDJSON_UINT64_C2(0xDBAC6C24, 0x7D62A583), RAPIDJSON_UINT64_C2(0xDF45F746, 0xB74ABF3A), // 1e-156
+        RAPIDJSON_UINT64_C2(0x894BC396, 0xCE5DA772), RAPIDJSON_UINT64_C2(0x6B8BBA8C, 0x328EB784), // 1e-155
+        RAPIDJSON_UINT64_C2(0xAB9EB47C, 0x81F5114F), RAPIDJSON_UINT64_C2(0x066EA92F, 0x3F326565), // 1e-154
+        RAPIDJSON_UINT64_C2(0xD686619B, 0xA27255A2), RAPIDJSON_UINT64_C2(0xC80A537B, 0x0EFEFEBE), // 1e-153
+        RAPIDJSON_UINT64_C2(0x8613FD01, 0x45877585), RAPIDJSON_UINT64_C2(0xBD06742C, 0xE95F5F37), // 1e-152
+        RAPIDJSON_UINT64_C2(0xA798FC41, 0x96E952E7), RAPIDJSON_UINT64_C2(0x2C481138, 0x23B73705), // 1e-151
+        RAPIDJSON_UINT64_C2(0xD17F3B51, 0xFCA3A7A0), RAPIDJSON_UINT64_C2(0xF75A1586, 0x2CA504C6), // 1e-150
+        RAPIDJSON_UINT64_C2(0x82EF8513, 0x3DE648C4), RAPIDJSON_UINT64_C2(0x9A984D73, 0xDBE722FC), // 1e-149
+        RAPIDJSON_UINT64_C2(0xA3AB6658, 0x0D5FDAF5), RAPIDJSON_UINT64_C2(0xC13E60D0, 0xD2E0EBBB), // 1e-148
+        RAPIDJSON_UINT64_C2(0xCC963FEE, 0x10B7D1B3), RAPIDJSON_UINT64_C2(0x318DF905, 0x079926A9), // 1e-147
+        RAPIDJSON_UINT64_C2(0xFFBBCFE9, 0x94E5C61F), RAPIDJSON_UINT64_C2(0xFDF17746, 0x497F7053), // 1e-146
+        RAPIDJSON_UINT64_C2(0x9FD561F1, 0xFD0F9BD3), RAPIDJSON_UINT64_C2(0xFEB6EA8B, 0xEDEFA634), // 1e-145
+        RAPIDJSON_UINT64_C2(0xC7CABA6E, 0x7C5382C8), RAPIDJSON_UINT64_C2(0xFE64A52E, 0xE96B8FC1), // 1e-144
+        RAPIDJSON_UINT64_C2(0xF9BD690A, 0x1B68637B), RAPIDJSON_UINT64_C2(0x3DFDCE7A, 0xA3C673B1), // 1e-143
+        RAPIDJSON_UINT64_C2(0x9C1661A6, 0x51213E2D), RAPIDJSON_UINT64_C2(0x06BEA10C, 0xA65C084F), // 1e-142
+        RAPIDJSON_UINT64_C2(0xC31BFA0F, 0xE5698DB8), RAPIDJSON_UINT64_C2(0x486E494F, 0xCFF30A63), // 1e-141
+        RAPIDJSON_UINT64_C2(0xF3E2F893, 0xDEC3F126), RAPIDJSON_UINT64_C2(0x5A89DBA3, 0xC3EFCCFB), // 1e-140
+        RAPIDJSON_UINT64_C2(0x986DDB5C, 0x6B3A76B7), RAPIDJSON_UINT64_C2(0xF8962946, 0x5A75E01D), // 1e-139
+        RAPIDJSON_UINT64_C2(0xBE895233, 0x86091465), RAPIDJSON_UINT64_C2(0xF6BBB397, 0xF1135824), // 1e-138
+        RAPIDJSON_UINT64_C2(0xEE2BA6C0, 0x678B597F), RAPIDJSON_UINT64_C2(0x746AA07D, 0xED582E2D), // 1e-137
+        RAPIDJSON_UINT64_C2(0x94DB4838, 0x40B717EF), RAPIDJSON_UINT64_C2(0xA8C2A44E, 0xB4571CDD), // 1e-136
+        RAPIDJSON_UINT64_C2(0xBA121A46, 0x50E4DDEB), RAPIDJSON_UINT64_C2(0x92F34D62, 0x616CE414), // 1e-135
+        RAPIDJSON_UINT64_C2(0xE896A0D7, 0xE51E1566), RAPIDJSON_UINT64_C2(0x77B020BA, 0xF9C81D18), // 1e-134
+        RAPIDJSON_UINT64_C2(0x915E2486, 0xEF32CD60), RAPIDJSON_UINT64_C2(0x0ACE1474, 0xDC1D122F), // 1e-133
+        RAPIDJSON_UINT64_C2(0xB5B5ADA8, 0xAAFF80B8), RAPIDJSON_UINT64_C2(0x0D819992, 0x132456BB), // 1e-132
+        RAPIDJSON_UINT64_C2(0xE3231912, 0xD5BF60E6), RAPIDJSON_UINT64_C2(0x10E1FFF6, 0x97ED6C6A), // 1e-131
+        RAPIDJSON_UINT64_C2(0x8DF5EFAB, 0xC5979C8F), RAPIDJSON_UINT64_C2(0xCA8D3FFA, 0x1EF463C2), // 1e-130
+        RAPIDJSON_UINT64_C2(0xB1736B96, 0xB6FD83B3), RAPIDJSON_UINT64_C2(0xBD308FF8, 0xA6B17CB3), // 1e-129
+        RAPIDJSON_UINT64_C2(0xDDD0467C, 0x64BCE4A0), RAPIDJSON_UINT64_C2(0xAC7CB3F6, 0xD05DDBDF), // 1e-128
+        RAPIDJSON_UINT64_C2(0x8AA22C0D, 0xBEF60EE4), RAPIDJSON_UINT64_C2(0x6BCDF07A, 0x423AA96C), // 1e-127
+        RAPIDJSON_UINT64_C2(0xAD4AB711, 0x2EB3929D), RAPIDJSON_UINT64_C2(0x86C16C98, 0xD2C953C7), // 1e-126
+        RAPIDJSON_UINT64_C2(0xD89D64D5, 0x7A607744), RAPIDJSON_UINT64_C2(0xE871C7BF, 0x077BA8B8), // 1e-125
+        RAPIDJSON_UINT64_C2(0x87625F05, 0x6C7C4A8B), RAPIDJSON_UINT64_C2(0x11471CD7, 0x64AD4973), // 1e-124
+        RAPIDJSON_UINT64_C2(0xA93AF6C6, 0xC79B5D2D), RAPIDJSON_UINT64_C2(0xD598E40D, 0x3DD89BD0), // 1e-123
+        RAPIDJSON_UINT64_C2(0xD389B478, 0x79823479), RAPIDJSON_UINT64_C2(0x4AFF1D10, 0x8D4EC2C4), // 1e-122
+        RAPIDJSON_UINT64_C2(0x843610CB, 0x4BF160CB), RAPIDJSON_UINT64_C2(0xCEDF722A, 0x585139BB), // 1e-121
+        RAPIDJSON_UINT64_C2(0xA54394FE, 0x1EEDB8FE), RAPIDJSON_UINT64_C2(0xC2974EB4, 0xEE658829), // 1e-120
+        RAPIDJSON_UINT64_C2(0xCE947A3D, 0xA6A9273E), RAPIDJSON_UINT64_C2(0x733D2262, 0x29FEEA33), // 1e-119
+        RAPIDJSON_UINT64_C2(0x811CCC66, 0x8829B887), RAPIDJSON_UINT64_C2(0x0806357D, 0x5A3F5260), // 1e-118
+        RAPIDJSON_UINT64_C2(0xA163FF80, 0x2A3426A8), RAPIDJSON_UINT64_C2(0xCA07C2DC, 0xB0CF26F8), // 1e-117
+        RAPIDJSON_UINT64_C2(0xC9BCFF60, 0x34C13052), RAPIDJSON_UINT64_C2(0xFC89B393, 0xDD02F0B6), // 1e-116
+        RAPIDJSON_UINT64_C2(0xFC2C3F38, 0x41F17C67), RAPIDJSON_UINT64_C2(0xBBAC2078, 0xD443ACE3), // 1e-115
+        RAPIDJSON_UINT64_C2(0x9D9BA783, 0x2936EDC0), RAPIDJSON_UINT64_C2(0xD54B944B, 0x84AA4C0E), // 1e-114
+        RAPIDJSON_UINT64_C2(0xC5029163, 0xF384A931), RAPIDJSON_UINT64_C2(0x0A9E795E, 0x65D4DF12), // 1e-113
+        RAPIDJSON_UINT64_C2(0xF64335BC, 0xF065D37D), RAPIDJSON_UINT64_C2(0x4D4617B5, 0xFF4A16D6), // 1e-112
+        RAPIDJSON_UINT64_C2(0x99EA0196, 0x163FA42E), RAPIDJSON_UINT64_C2(0x504BCED1, 0xBF8E4E46), // 1e-111
+        RAPIDJSON_UINT64_C2(0xC06481FB, 0x9BCF8D39), RAPIDJSON_UINT64_C2(0xE45EC286, 0x2F71E1D7), // 1e-110
+        RAPIDJSON_UINT64_C2(0xF07DA27A, 0x82C37088), RAPIDJSON_UINT64_C2(0x5D767327, 0xBB4E5A4D), // 1e-109
+        RAPIDJSON_UINT64_C2(0x964E858C, 0x91BA2655), RAPIDJSON_UINT64_C2(0x3A6A07F8, 0xD510F870), // 1e-108
+        RAPIDJSON_UINT64_C2(0xBBE226EF, 0xB628AFEA), RAPIDJSON_UINT64_C2(0x890489F7, 0x0A55368C), // 1e-107
+        RAPIDJSON_UINT64_C2(0xEADAB0AB, 0xA3B2DBE5), RAPIDJSON_UINT64_C2(0x2B45AC74, 0xCCEA842F), // 1e-106
+        RAPIDJSON_UINT64_C2(0x92C8AE6B, 0x464FC96F), RAPIDJSON_UINT64_C2(0x3B0B8BC9, 0x0012929E), // 1e-105
+        RAPIDJSON_UINT64_C2(0xB77ADA06, 0x17E3BBCB), RAPIDJSON_UINT64_C2(0x09CE6EBB, 0x40173745), // 1e-104
+        RAPIDJSON_UINT64_C2(0xE5599087, 0x9DDCAABD), RAPIDJSON_UINT64_C2(0xCC420A6A, 0x101D0516), // 1e-103
+        RAPIDJSON_UINT64_C2(0x8F57FA54, 0xC2A9EAB6), RAPIDJSON_UINT64_C2(0x9FA94682, 0x4A12232E), // 1e-102
+        RAPIDJSON_UINT64_C2(0xB32DF8E9, 0xF3546564), RAPIDJSON_UINT64_C2(0x47939822, 0xDC96ABFA), // 1e-101
+        RAPIDJSON_UINT64_C2(0xDFF97724, 0x70297EBD), RAPIDJSON_UINT64_C2(0x59787E2B, 0x93BC56F8), // 1e-100
+        RAPIDJSON_UINT64_C2(0x8BFBEA76, 0xC619EF36), RAPIDJSON_UINT64_C2(0x57EB4EDB, 0x3C55B65B), // 1e-99
+        RAPIDJSON_UINT64_C2(0xAEFAE514, 0x77A06B03), RAPIDJSON_UINT64_C2(0xEDE62292, 0x0B6B23F2), // 1e-98
+        RAPIDJSON_UINT64_C2(0xDAB99E59, 0x958885C4), RAPIDJSON_UINT64_C2(0xE95FAB36, 0x8E45ECEE), // 1e-97
+        RAPIDJSON_UINT64_C2(0x88B402F7, 0xFD75539B), RAPIDJSON_UINT64_C2(0x11DBCB02, 0x18EBB415), // 1e-96
+        RAPIDJSON_UINT64_C2(0xAAE103B5, 0xFCD2A881), RAPIDJSON_UINT64_C2(0xD652BDC2, 0x9F26A11A), // 1e-95
+        RAPIDJSON_UINT64_C2(0xD59944A3, 0x7C0752A2), RAPIDJSON_UINT64_C2(0x4BE76D33, 0x46F04960), // 1e-94
+        RAPIDJSON_UINT64_C2(0x857FCAE6, 0x2D8493A5), RAPIDJSON_UINT64_C2(0x6F70A440, 0x0C562DDC), // 1e-93
+        RAPIDJSON_UINT64_C2(0xA6DFBD9F, 0xB8E5B88E), RAPIDJSON_UINT64_C2(0xCB4CCD50, 0x0F6BB953), // 1e-92
+        RAPIDJSON_UINT64_C2(0xD097AD07, 0xA71F26B2), RAPIDJSON_UINT64_C2(0x7E2000A4, 0x1346A7A8), // 1e-91
+        RAPIDJSON_UINT64_C2(0x825ECC24, 0xC873782F), RAPIDJSON_UINT64_C2(0x8ED40066, 0x8C0C28C9), // 1e-90
+        RAPIDJSON_UINT64_C2(0xA2F67F2D, 0xFA90563B), RAPIDJSON_UINT64_C2(0x72890080, 0x2F0F32FB), // 1e-89
+        RAPIDJSON_UINT64_C2(0xCBB41EF9, 0x79346BCA), RAPIDJSON_UINT64_C2(0x4F2B40A0, 0x3AD2FFBA), // 1e-88
+        RAPIDJSON_UINT64_C2(0xFEA126B7, 0xD78186BC), RAPIDJSON_UINT64_C2(0xE2F610C8, 0x4987BFA9), // 1e-87
+        RAPIDJSON_UINT64_C2(0x9F24B832, 0xE6B0F436), RAPIDJSON_UINT64_C2(0x0DD9CA7D, 0x2DF4D7CA), // 1e-86
+        RAPIDJSON_UINT64_C2(0xC6EDE63F, 0xA05D3143), RAPIDJSON_UINT64_C2(0x91503D1C, 0x79720DBC), // 1e-85
+        RAPIDJSON_UINT64_C2(0xF8A95FCF, 0x88747D94), RAPIDJSON_UINT64_C2(0x75A44C63, 0x97CE912B), // 1e-84
+        RAPIDJSON_UINT64_C2(0x9B69DBE1, 0xB548CE7C), RAPIDJSON_UINT64_C2(0xC986AFBE, 0x3EE11ABB), // 1e-83
+        RAPIDJSON_UINT64_C2(0xC24452DA, 0x229B021B), RAPIDJSON_UINT64_C2(0xFBE85BAD, 0xCE996169), // 1e-82
+        RAPIDJSON_UINT64_C2(0xF2D56790, 0xAB41C2A2), RAPIDJSON_UINT64_C2(0xFAE27299, 0x423FB9C4), // 1e-81
+        RAPIDJSON_UINT64_C2(0x97C560BA, 0x6B0919A5), RAPIDJSON_UINT64_C2(0xDCCD879F, 0xC967D41B), // 1e-80
+        RAPIDJSON_UINT64_C2(0xBDB6B8E9, 0x05CB600F), RAPIDJSON_UINT64_C2(0x5400E987, 0xBBC1C921), // 1e-79
+        RAPIDJSON_UINT64_C2(0xED246723, 0x473E3813), RAPIDJSON_UINT64_C2(0x290123E9, 0xAAB23B69), // 1e-78
+        RAPIDJSON_UINT64_C2(0x9436C076, 0x0C86E30B), RAPIDJSON_UINT64_C2(0xF9A0B672, 0x0AAF6522), // 1e-77
+        RAPIDJSON_UINT64_C2(0xB9447093, 0x8FA89BCE), RAPIDJSON_UINT64_C2(0xF808E40E, 0x8D5B3E6A), // 1e-76
+        RAPIDJSON_UINT64_C2(0xE7958CB8, 0x7392C2C2), RAPIDJSON_UINT64_C2(0xB60B1D12, 0x30B20E05), // 1e-75
+        RAPIDJSON_UINT64_C2(0x90BD77F3, 0x483BB9B9), RAPIDJSON_UINT64_C2(0xB1C6F22B, 0x5E6F48C3), // 1e-74
+        RAPIDJSON_UINT64_C2(0xB4ECD5F0, 0x1A4AA828), RAPIDJSON_UINT64_C2(0x1E38AEB6, 0x360B1AF4), // 1e-73
+        RAPIDJSON_UINT64_C2(0xE2280B6C, 0x20DD5232), RAPIDJSON_UINT64_C2(0x25C6DA63, 0xC38DE1B1), // 1e-72
+        RAPIDJSON_UINT64_C2(0x8D590723, 0x948A535F), RAPIDJSON_UINT64_C2(0x579C487E, 0x5A38AD0F), // 1e-71
+        RAPIDJSON_UINT64_C2(0xB0AF48EC, 0x79ACE837), RAPIDJSON_UINT64_C2(0x2D835A9D, 0xF0C6D852), // 1e-70
+        RAPIDJSON_UINT64_C2(0xDCDB1B27, 0x98182244), RAPIDJSON_UINT64_C2(0xF8E43145, 0x6CF88E66), // 1e-69
+        RAPIDJSON_UINT64_C2(0x8A08F0F8, 0xBF0F156B), RAPIDJSON_UINT64_C2(0x1B8E9ECB, 0x641B5900), // 1e-68
+        RAPIDJSON_UINT64_C2(0xAC8B2D36, 0xEED2DAC5), RAPIDJSON_UINT64_C2(0xE272467E, 0x3D222F40), // 1e-67
+        RAPIDJSON_UINT64_C2(0xD7ADF884, 0xAA879177), RAPIDJSON_UINT64_C2(0x5B0ED81D, 0xCC6ABB10), // 1e-66
+        RAPIDJSON_UINT64_C2(0x86CCBB52, 0xEA94BAEA), RAPIDJSON_UINT64_C2(0x98E94712, 0x9FC2B4EA), // 1e-65
+        RAPIDJSON_UINT64_C2(0xA87FEA27, 0xA539E9A5), RAPIDJSON_UINT64_C2(0x3F2398D7, 0x47B36225), // 1e-64
+        RAPIDJSON_UINT64_C2(0xD29FE4B1, 0x8E88640E), RAPIDJSON_UINT64_C2(0x8EEC7F0D, 0x19A03AAE), // 1e-63
+        RAPIDJSON_UINT64_C2(0x83A3EEEE, 0xF9153E89), RAPIDJSON_UINT64_C2(0x1953CF68, 0x300424AD), // 1e-62
+        RAPIDJSON_UINT64_C2(0xA48CEAAA, 0xB75A8E2B), RAPIDJSON_UINT64_C2(0x5FA8C342, 0x3C052DD8), // 1e-61
+        RAPIDJSON_UINT64_C2(0xCDB02555, 0x653131B6), RAPIDJSON_UINT64_C2(0x3792F412, 0xCB06794E), // 1e-60
+        RAPIDJSON_UINT64_C2(0x808E1755, 0x5F3EBF11), RAPIDJSON_UINT64_C2(0xE2BBD88B, 0xBEE40BD1), // 1e-59
+        RAPIDJSON_UINT64_C2(0xA0B19D2A, 0xB70E6ED6), RAPIDJSON_UINT64_C2(0x5B6ACEAE, 0xAE9D0EC5), // 1e-58
+        RAPIDJSON_UINT64_C2(0xC8DE0475, 0x64D20A8B), RAPIDJSON_UINT64_C2(0xF245825A, 0x5A445276), // 1e-57
+        RAPIDJSON_UINT64_C2(0xFB158592, 0xBE068D2E), RAPIDJSON_UINT64_C2(0xEED6E2F0, 0xF0D56713), // 1e-56
+        RAPIDJSON_UINT64_C2(0x9CED737B, 0xB6C4183D), RAPIDJSON_UINT64_C2(0x55464DD6, 0x9685606C), // 1e-55
+        RAPIDJSON_UINT64_C2(0xC428D05A, 0xA4751E4C), RAPIDJSON_UINT64_C2(0xAA97E14C, 0x3C26B887), // 1e-54
+        RAPIDJSON_UINT64_C2(0xF5330471, 0x4D9265DF), RAPIDJSON_UINT64_C2(0xD53DD99F, 0x4B3066A9), // 1e-53
+        RAPIDJSON_UINT64_C2(0x993FE2C6, 0xD07B7FAB), RAPIDJSON_UINT64_C2(0xE546A803, 0x8EFE402A), // 1e-52
+        RAPIDJSON_UINT64_C2(0xBF8FDB78, 0x849A5F96), RAPIDJSON_UINT64_C2(0xDE985204, 0x72BDD034), // 1e-51
+        RAPIDJSON_UINT64_C2(0xEF73D256, 0xA5C0F77C), RAPIDJSON_UINT64_C2(0x963E6685, 0x8F6D4441), // 1e-50
+        RAPIDJSON_UINT64_C2(0x95A86376, 0x27989AAD), RAPIDJSON_UINT64_C2(0xDDE70013, 0x79A44AA9), // 1e-49
+        RAPIDJSON_UINT64_C2(0xBB127C53, 0xB17EC159), RAPIDJSON_UINT64_C2(0x5560C018, 0x580D5D53), // 1e-48
+        RAPIDJSON_UINT64_C2(0xE9D71B68, 0x9DDE71AF), RAPIDJSON_UINT64_C2(0xAAB8F01E, 0x6E10B4A7), // 1e-47
+        RAPIDJSON_UINT64_C2(0x92267121, 0x62AB070D), RAPIDJSON_UINT64_C2(0xCAB39613, 0x04CA70E9), // 1e-46
+        RAPIDJSON_UINT64_C2(0xB6B00D69, 0xBB55C8D1), RAPIDJSON_UINT64_C2(0x3D607B97, 0xC5FD0D23), // 1e-45
+        RAPIDJSON_UINT64_C2(0xE45C10C4, 0x2A2B3B05), RAPIDJSON_UINT64_C2(0x8CB89A7D, 0xB77C506B), // 1e-44
+        RAPIDJSON_UINT64_C2(0x8EB98A7A, 0x9A5B04E3), RAPIDJSON_UINT64_C2(0x77F3608E, 0x92ADB243), // 1e-43
+        RAPIDJSON_UINT64_C2(0xB267ED19, 0x40F1C61C), RAPIDJSON_UINT64_C2(0x55F038B2, 0x37591ED4), // 1e-42
+        RAPIDJSON_UINT64_C2(0xDF01E85F, 0x912E37A3), RAPIDJSON_UINT64_C2(0x6B6C46DE, 0xC52F6689), // 1e-41
+        RAPIDJSON_UINT64_C2(0x8B61313B, 0xBABCE2C6), RAPIDJSON_UINT64_C2(0x2323AC4B, 0x3B3DA016), // 1e-40
+        RAPIDJSON_UINT64_C2(0xAE397D8A, 0xA96C1B77), RAPIDJSON_UINT64_C2(0xABEC975E, 0x0A0D081B), // 1e-39
+        RAPIDJSON_UINT64_C2(0xD9C7DCED, 0x53C72255), RAPIDJSON_UINT64_C2(0x96E7BD35, 0x8C904A22), // 1e-38
+        RAPIDJSON_UINT64_C2(0x881CEA14, 0x545C7575), RAPIDJSON_UINT64_C2(0x7E50D641, 0x77DA2E55), // 1e-37
+        RAPIDJSON_UINT64_C2(0xAA242499, 0x697392D2), RAPIDJSON_UINT64_C2(0xDDE50BD1, 0xD5D0B9EA), // 1e-36
+        RAPIDJSON_UINT64_C2(0xD4AD2DBF, 0xC3D07787), RAPIDJSON_UINT64_C2(0x955E4EC6, 0x4B44E865), // 1e-35
+        RAPIDJSON_UINT64_C2(0x84EC3C97, 0xDA624AB4), RAPIDJSON_UINT64_C2(0xBD5AF13B, 0xEF0B113F), // 1e-34
+        RAPIDJSON_UINT64_C2(0xA6274BBD, 0xD0FADD61), RAPIDJSON_UINT64_C2(0xECB1AD8A, 0xEACDD58F), // 1e-33
+        RAPIDJSON_UINT64_C2(0xCFB11EAD, 0x453994BA), RAPIDJSON_UINT64_C2(0x67DE18ED, 0xA5814AF3), // 1e-32
+        RAPIDJSON_UINT64_C2(0x81CEB32C, 0x4B43FCF4), RAPIDJSON_UINT64_C2(0x80EACF94, 0x8770CED8), // 1e-31
+        RAPIDJSON_UINT64_C2(0xA2425FF7, 0x5E14FC31), RAPIDJSON_UINT64_C2(0xA1258379, 0xA94D028E), // 1e-30
+        RAPIDJSON_UINT64_C2(0xCAD2F7F5, 0x359A3B3E), RAPIDJSON_UINT64_C2(0x096EE458, 0x13A04331), // 1e-29
+        RAPIDJSON_UINT64_C2(0xFD87B5F2, 0x8300CA0D), RAPIDJSON_UINT64_C2(0x8BCA9D6E, 0x188853FD), // 1e-28
+        RAPIDJSON_UINT64_C2(0x9E74D1B7, 0x91E07E48), RAPIDJSON_UINT64_C2(0x775EA264, 0xCF55347E), // 1e-27
+        RAPIDJSON_UINT64_C2(0xC6120625, 0x76589DDA), RAPIDJSON_UINT64_C2(0x95364AFE, 0x032A819E), // 1e-26
+        RAPIDJSON_UINT64_C2(0xF79687AE, 0xD3EEC551), RAPIDJSON_UINT64_C2(0x3A83DDBD, 0x83F52205), // 1e-25
+        RAPIDJSON_UINT64_C2(0x9ABE14CD, 0x44753B52), RAPIDJSON_UINT64_C2(0xC4926A96, 0x72793543), // 1e-24
+        RAPIDJSON_UINT64_C2(0xC16D9A00, 0x95928A27), RAPIDJSON_UINT64_C2(0x75B7053C, 0x0F178294), // 1e-23
+        RAPIDJSON_UINT64_C2(0xF1C90080, 0xBAF72CB1), RAPIDJSON_UINT64_C2(0x5324C68B, 0x12DD6339), // 1e-22
+        RAPIDJSON_UINT64_C2(0x971DA050, 0x74DA7BEE), RAPIDJSON_UINT64_C2(0xD3F6FC16, 0xEBCA5E04), // 1e-21
+        RAPIDJSON_UINT64_C2(0xBCE50864, 0x92111AEA), RAPIDJSON_UINT64_C2(0x88F4BB1C, 0xA6BCF585), // 1e-20
+        RAPIDJSON_UINT64_C2(0xEC1E4A7D, 0xB69561A5), RAPIDJSON_UINT64_C2(0x2B31E9E3, 0xD06C32E6), // 1e-19
+        RAPIDJSON_UINT64_C2(0x9392EE8E, 0x921D5D07), RAPIDJSON_UINT64_C2(0x3AFF322E, 0x62439FD0), // 1e-18
+        RAPIDJSON_UINT64_C2(0xB877AA32, 0x36A4B449), RAPIDJSON_UINT64_C2(0x09BEFEB9, 0xFAD487C3), // 1e-17
+        RAPIDJSON_UINT64_C2(0xE69594BE, 0xC44DE15B), RAPIDJSON_UINT64_C2(0x4C2EBE68, 0x7989A9B4), // 1e-16
+        RAPIDJSON_UINT64_C2(0x901D7CF7, 0x3AB0ACD9), RAPIDJSON_UINT64_C2(0x0F9D3701, 0x4BF60A11), // 1e-15
+        RAPIDJSON_UINT64_C2(0xB424DC35, 0x095CD80F), RAPIDJSON_UINT64_C2(0x538484C1, 0x9EF38C95), // 1e-14
+        RAPIDJSON_UINT64_C2(0xE12E1342, 0x4BB40E13), RAPIDJSON_UINT64_C2(0x2865A5F2, 0x06B06FBA), // 1e-13
+        RAPIDJSON_UINT64_C2(0x8CBCCC09, 0x6F5088CB), RAPIDJSON_UINT64_C2(0xF93F87B7, 0x442E45D4), // 1e-12
+        RAPIDJSON_UINT64_C2(0xAFEBFF0B, 0xCB24AAFE), RAPIDJSON_UINT64_C2(0xF78F69A5, 0x1539D749), // 1e-11
+        RAPIDJSON_UINT64_C2(0xDBE6FECE, 0xBDEDD5BE), RAPIDJSON_UINT64_C2(0xB573440E, 0x5A884D1C), // 1e-10
+        RAPIDJSON_UINT64_C2(0x89705F41, 0x36B4A597), RAPIDJSON_UINT64_C2(0x31680A88, 0xF8953031), // 1e-9
+        RAPIDJSON_UINT64_C2(0xABCC7711, 0x8461CEFC), RAPIDJSON_UINT64_C2(0xFDC20D2B, 0x36BA7C3E), // 1e-8
+        RAPIDJSON_UINT64_C2(0xD6BF94D5, 0xE57A42BC), RAPIDJSON_UINT64_C2(0x3D329076, 0x04691B4D), // 1e-7
+        RAPIDJSON_UINT64_C2(0x8637BD05, 0xAF6C69B5), RAPIDJSON_UINT64_C2(0xA63F9A49, 0xC2C1B110), // 1e-6
+        RAPIDJSON_UINT64_C2(0xA7C5AC47, 0x1B478423), RAPIDJSON_UINT64_C2(0x0FCF80DC, 0x33721D54), // 1e-5
+        RAPIDJSON_UINT64_C2(0xD1B71758, 0xE219652B), RAPIDJSON_UINT64_C2(0xD3C36113, 0x404EA4A9), // 1e-4
+        RAPIDJSON_UINT64_C2(0x83126E97, 0x8D4FDF3B), RAPIDJSON_UINT64_C2(0x645A1CAC, 0x083126EA), // 1e-3
+        RAPIDJSON_UINT64_C2(0xA3D70A3D, 0x70A3D70A), RAPIDJSON_UINT64_C2(0x3D70A3D7, 0x0A3D70A4), // 1e-2
+        RAPIDJSON_UINT64_C2(0xCCCCCCCC, 0xCCCCCCCC), RAPIDJSON_UINT64_C2(0xCCCCCCCC, 0xCCCCCCCD), // 1e-1
+        RAPIDJSON_UINT64_C2(0x80000000, 0x00000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e0
+        RAPIDJSON_UINT64_C2(0xA0000000, 0x00000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e1
+        RAPIDJSON_UINT64_C2(0xC8000000, 0x00000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e2
+        RAPIDJSON_UINT64_C2(0xFA000000, 0x00000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e3
+        RAPIDJSON_UINT64_C2(0x9C400000, 0x00000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e4
+        RAPIDJSON_UINT64_C2(0xC3500000, 0x00000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e5
+        RAPIDJSON_UINT64_C2(0xF4240000, 0x00000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e6
+        RAPIDJSON_UINT64_C2(0x98968000, 0x00000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e7
+        RAPIDJSON_UINT64_C2(0xBEBC2000, 0x00000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e8
+        RAPIDJSON_UINT64_C2(0xEE6B2800, 0x00000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e9
+        RAPIDJSON_UINT64_C2(0x9502F900, 0x00000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e10
+        RAPIDJSON_UINT64_C2(0xBA43B740, 0x00000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e11
+        RAPIDJSON_UINT64_C2(0xE8D4A510, 0x00000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e12
+        RAPIDJSON_UINT64_C2(0x9184E72A, 0x00000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e13
+        RAPIDJSON_UINT64_C2(0xB5E620F4, 0x80000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e14
+        RAPIDJSON_UINT64_C2(0xE35FA931, 0xA0000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e15
+        RAPIDJSON_UINT64_C2(0x8E1BC9BF, 0x04000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e16
+        RAPIDJSON_UINT64_C2(0xB1A2BC2E, 0xC5000000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e17
+        RAPIDJSON_UINT64_C2(0xDE0B6B3A, 0x76400000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e18
+        RAPIDJSON_UINT64_C2(0x8AC72304, 0x89E80000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e19
+        RAPIDJSON_UINT64_C2(0xAD78EBC5, 0xAC620000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e20
+        RAPIDJSON_UINT64_C2(0xD8D726B7, 0x177A8000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e21
+        RAPIDJSON_UINT64_C2(0x87867832, 0x6EAC9000), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e22
+        RAPIDJSON_UINT64_C2(0xA968163F, 0x0A57B400), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e23
+        RAPIDJSON_UINT64_C2(0xD3C21BCE, 0xCCEDA100), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e24
+        RAPIDJSON_UINT64_C2(0x84595161, 0x401484A0), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e25
+        RAPIDJSON_UINT64_C2(0xA56FA5B9, 0x9019A5C8), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e26
+        RAPIDJSON_UINT64_C2(0xCECB8F27, 0xF4200F3A), RAPIDJSON_UINT64_C2(0x00000000, 0x00000001), // 1e27
+        RAPIDJSON_UINT64_C2(0x813F3978, 0xF8940984), RAPIDJSON_UINT64_C2(0x40000000, 0x00000001), // 1e28
+        RAPIDJSON_UINT64_C2(0xA18F07D7, 0x36B90BE5), RAPIDJSON_UINT64_C2(0x50000000, 0x00000001), // 1e29
+        RAPIDJSON_UINT64_C2(0xC9F2C9CD, 0x04674EDE), RAPIDJSON_UINT64_C2(0xA4000000, 0x00000001), // 1e30
+        RAPIDJSON_UINT64_C2(0xFC6F7C40, 0x45812296), RAPIDJSON_UINT64_C2(0x4D000000, 0x00000001), // 1e31
+        RAPIDJSON_UINT64_C2(0x9DC5ADA8, 0x2B70B59D), RAPIDJSON_UINT64_C2(0xF0200000, 0x00000001), // 1e32
+        RAPIDJSON_UINT64_C2(0xC5371912, 0x364CE305), RAPIDJSON_UINT64_C2(0x6C280000, 0x00000001), // 1e33
+        RAPIDJSON_UINT64_C2(0xF684DF56, 0xC3E01BC6), RAPIDJSON_UINT64_C2(0xC7320000, 0x00000001), // 1e34
+        RAPIDJSON_UINT64_C2(0x9A130B96, 0x3A6C115C), RAPIDJSON_UINT64_C2(0x3C7F4000, 0x00000001), // 1e35
+        RAPIDJSON_UINT64_C2(0xC097CE7B, 0xC90715B3), RAPIDJSON_UINT64_C2(0x4B9F1000, 0x00000001), // 1e36
+        RAPIDJSON_UINT64_C2(0xF0BDC21A, 0xBB48DB20), RAPIDJSON_UINT64_C2(0x1E86D400, 0x00000001), // 1e37
+        RAPIDJSON_UINT64_C2(0x96769950, 0xB50D88F4), RAPIDJSON_UINT64_C2(0x13144480, 0x00000001), // 1e38
+        RAPIDJSON_UINT64_C2(0xBC143FA4, 0xE250EB31), RAPIDJSON_UINT64_C2(0x17D955A0, 0x00000001), // 1e39
+        RAPIDJSON_UINT64_C2(0xEB194F8E, 0x1AE525FD), RAPIDJSON_UINT64_C2(0x5DCFAB08, 0x00000001), // 1e40
+        RAPIDJSON_UINT64_C2(0x92EFD1B8, 0xD0CF37BE), RAPIDJSON_UINT64_C2(0x5AA1CAE5, 0x00000001), // 1e41
+        RAPIDJSON_UINT64_C2(0xB7ABC627, 0x050305AD), RAPIDJSON_UINT64_C2(0xF14A3D9E, 0x40000001), // 1e42
+        RAPIDJSON_UINT64_C2(0xE596B7B0, 0xC643C719), RAPIDJSON_UINT64_C2(0x6D9CCD05, 0xD0000001), // 1e43
+        RAPIDJSON_UINT64_C2(0x8F7E32CE, 0x7BEA5C6F), RAPIDJSON_UINT64_C2(0xE4820023, 0xA2000001), // 1e44
+        RAPIDJSON_UINT64_C2(0xB35DBF82, 0x1AE4F38B), RAPIDJSON_UINT64_C2(0xDDA2802C, 0x8A800001), // 1e45
+        RAPIDJSON_UINT64_C2(0xE0352F62, 0xA19E306E), RAPIDJSON_UINT64_C2(0xD50B2037, 0xAD200001), // 1e46
+        RAPIDJSON_UINT64_C2(0x8C213D9D, 0xA502DE45), RAPIDJSON_UINT64_C2(0x4526F422, 0xCC340001), // 1e47
+        RAPIDJSON_UINT64_C2(0xAF298D05, 0x0E4395D6), RAPIDJSON_UINT64_C2(0x9670B12B, 0x7F410001), // 1e48
+        RAPIDJSON_UINT64_C2(0xDAF3F046, 0x51D47B4C), RAPIDJSON_UINT64_C2(0x3C0CDD76, 0x5F114001), // 1e49
+        RAPIDJSON_UINT64_C2(0x88D8762B, 0xF324CD0F), RAPIDJSON_UINT64_C2(0xA5880A69, 0xFB6AC801), // 1e50
+        RAPIDJSON_UINT64_C2(0xAB0E93B6, 0xEFEE0053), RAPIDJSON_UINT64_C2(0x8EEA0D04, 0x7A457A01), // 1e51
+        RAPIDJSON_UINT64_C2(0xD5D238A4, 0xABE98068), RAPIDJSON_UINT64_C2(0x72A49045, 0x98D6D881), // 1e52
+        RAPIDJSON_UINT64_C2(0x85A36366, 0xEB71F041), RAPIDJSON_UINT64_C2(0x47A6DA2B, 0x7F864751), // 1e53
+        RAPIDJSON_UINT64_C2(0xA70C3C40, 0xA64E6C51), RAPIDJSON_UINT64_C2(0x999090B6, 0x5F67D925), // 1e54
+        RAPIDJSON_UINT64_C2(0xD0CF4B50, 0xCFE20765), RAPIDJSON_UINT64_C2(0xFFF4B4E3, 0xF741CF6E), // 1e55
+        RAPIDJSON_UINT64_C2(0x82818F12, 0x81ED449F), RAPIDJSON_UINT64_C2(0xBFF8F10E, 0x7A8921A5), // 1e56
+        RAPIDJSON_UINT64_C2(0xA321F2D7, 0x226895C7), RAPIDJSON_UINT64_C2(0xAFF72D52, 0x192B6A0E), // 1e57
+        RAPIDJSON_UINT64_C2(0xCBEA6F8C, 0xEB02BB39), RAPIDJSON_UINT64_C2(0x9BF4F8A6, 0x9F764491), // 1e58
+        RAPIDJSON_UINT64_C2(0xFEE50B70, 0x25C36A08), RAPIDJSON_UINT64_C2(0x02F236D0, 0x4753D5B5), // 1e59
+        RAPIDJSON_UINT64_C2(0x9F4F2726, 0x179A2245), RAPIDJSON_UINT64_C2(0x01D76242, 0x2C946591), // 1e60
+        RAPIDJSON_UINT64_C2(0xC722F0EF, 0x9D80AAD6), RAPIDJSON_UINT64_C2(0x424D3AD2, 0xB7B97EF6), // 1e61
+        RAPIDJSON_UINT64_C2(0xF8EBAD2B, 0x84E0D58B), RAPIDJSON_UINT64_C2(0xD2E08987, 0x65A7DEB3), // 1e62
+        RAPIDJSON_UINT64_C2(0x9B934C3B, 0x330C8577), RAPIDJSON_UINT64_C2(0x63CC55F4, 0x9F88EB30), // 1e63
+        RAPIDJSON_UINT64_C2(0xC2781F49, 0xFFCFA6D5), RAPIDJSON_UINT64_C2(0x3CBF6B71, 0xC76B25FC), // 1e64
+        RAPIDJSON_UINT64_C2(0xF316271C, 0x7FC3908A), RAPIDJSON_UINT64_C2(0x8BEF464E, 0x3945EF7B), // 1e65
+        RAPIDJSON_UINT64_C2(0x97EDD871, 0xCFDA3A56), RAPIDJSON_UINT64_C2(0x97758BF0, 0xE3CBB5AD), // 1e66
+        RAPIDJSON_UINT64_C2(0xBDE94E8E, 0x43D0C8EC), RAPIDJSON_UINT64_C2(0x3D52EEED, 0x1CBEA318), // 1e67
+        RAPIDJSON_UINT64_C2(0xED63A231, 0xD4C4FB27), RAPIDJSON_UINT64_C2(0x4CA7AAA8, 0x63EE4BDE), // 1e68
+        RAPIDJSON_UINT64_C2(0x945E455F, 0x24FB1CF8), RAPIDJSON_UINT64_C2(0x8FE8CAA9, 0x3E74EF6B), // 1e69
+        RAPIDJSON_UINT64_C2(0xB975D6B6, 0xEE39E436), RAPIDJSON_UINT64_C2(0xB3E2FD53, 0x8E122B45), // 1e70
+        RAPIDJSON_UINT64_C2(0xE7D34C64, 0xA9C85D44), RAPIDJSON_UINT64_C2(0x60DBBCA8, 0x7196B617), // 1e71
+        RAPIDJSON_UINT64_C2(0x90E40FBE, 0xEA1D3A4A), RAPIDJSON_UINT64_C2(0xBC8955E9, 0x46FE31CE), // 1e72
+        RAPIDJSON_UINT64_C2(0xB51D13AE, 0xA4A488DD), RAPIDJSON_UINT64_C2(0x6BABAB63, 0x98BDBE42), // 1e73
+        RAPIDJSON_UINT64_C2(0xE264589A, 0x4DCDAB14), RAPIDJSON_UINT64_C2(0xC696963C, 0x7EED2DD2), // 1e74
+        RAPIDJSON_UINT64_C2(0x8D7EB760, 0x70A08AEC), RAPIDJSON_UINT64_C2(0xFC1E1DE5, 0xCF543CA3), // 1e75
+        RAPIDJSON_UINT64_C2(0xB0DE6538, 0x8CC8ADA8), RAPIDJSON_UINT64_C2(0x3B25A55F, 0x43294BCC), // 1e76
+        RAPIDJSON_UINT64_C2(0xDD15FE86, 0xAFFAD912), RAPIDJSON_UINT64_C2(0x49EF0EB7, 0x13F39EBF), // 1e77
+        RAPIDJSON_UINT64_C2(0x8A2DBF14, 0x2DFCC7AB), RAPIDJSON_UINT64_C2(0x6E356932, 0x6C784338), // 1e78
+        RAPIDJSON_UINT64_C2(0xACB92ED9, 0x397BF996), RAPIDJSON_UINT64_C2(0x49C2C37F, 0x07965405), // 1e79
+        RAPIDJSON_UINT64_C2(0xD7E77A8F, 0x87DAF7FB), RAPIDJSON_UINT64_C2(0xDC33745E, 0xC97BE907), // 1e80
+        RAPIDJSON_UINT64_C2(0x86F0AC99, 0xB4E8DAFD), RAPIDJSON_UINT64_C2(0x69A028BB, 0x3DED71A4), // 1e81
+        RAPIDJSON_UINT64_C2(0xA8ACD7C0, 0x222311BC), RAPIDJSON_UINT64_C2(0xC40832EA, 0x0D68CE0D), // 1e82
+        RAPIDJSON_UINT64_C2(0xD2D80DB0, 0x2AABD62B), RAPIDJSON_UINT64_C2(0xF50A3FA4, 0x90C30191), // 1e83
+        RAPIDJSON_UINT64_C2(0x83C7088E, 0x1AAB65DB), RAPIDJSON_UINT64_C2(0x792667C6, 0xDA79E0FB), // 1e84
+        RAPIDJSON_UINT64_C2(0xA4B8CAB1, 0xA1563F52), RAPIDJSON_UINT64_C2(0x577001B8, 0x91185939), // 1e85
+        RAPIDJSON_UINT64_C2(0xCDE6FD5E, 0x09ABCF26), RAPIDJSON_UINT64_C2(0xED4C0226, 0xB55E6F87), // 1e86
+        RAPIDJSON_UINT64_C2(0x80B05E5A, 0xC60B6178), RAPIDJSON_UINT64_C2(0x544F8158, 0x315B05B5), // 1e87
+        RAPIDJSON_UINT64_C2(0xA0DC75F1, 0x778E39D6), RAPIDJSON_UINT64_C2(0x696361AE, 0x3DB1C722), // 1e88
+        RAPIDJSON_UINT64_C2(0xC913936D, 0xD571C84C), RAPIDJSON_UINT64_C2(0x03BC3A19, 0xCD1E38EA), // 1e89
+        RAPIDJSON_UINT64_C2(0xFB587849, 0x4ACE3A5F), RAPIDJSON_UINT64_C2(0x04AB48A0, 0x4065C724), // 1e90
+        RAPIDJSON_UINT64_C2(0x9D174B2D, 0xCEC0E47B), RAPIDJSON_UINT64_C2(0x62EB0D64, 0x283F9C77), // 1e91
+        RAPIDJSON_UINT64_C2(0xC45D1DF9, 0x42711D9A), RAPIDJSON_UINT64_C2(0x3BA5D0BD, 0x324F8395), // 1e92
+        RAPIDJSON_UINT64_C2(0xF5746577, 0x930D6500), RAPIDJSON_UINT64_C2(0xCA8F44EC, 0x7EE3647A), // 1e93
+        RAPIDJSON_UINT64_C2(0x9968BF6A, 0xBBE85F20), RAPIDJSON_UINT64_C2(0x7E998B13, 0xCF4E1ECC), // 1e94
+        RAPIDJSON_UINT64_C2(0xBFC2EF45, 0x6AE276E8), RAPIDJSON_UINT64_C2(0x9E3FEDD8, 0xC321A67F), // 1e95
+        RAPIDJSON_UINT64_C2(0xEFB3AB16, 0xC59B14A2), RAPIDJSON_UINT64_C2(0xC5CFE94E, 0xF3EA101F), // 1e96
+        RAPIDJSON_UINT64_C2(0x95D04AEE, 0x3B80ECE5), RAPIDJSON_UINT64_C2(0xBBA1F1D1, 0x58724A13), // 1e97
+        RAPIDJSON_UINT64_C2(0xBB445DA9, 0xCA61281F), RAPIDJSON_UINT64_C2(0x2A8A6E45, 0xAE8EDC98), // 1e98
+        RAPIDJSON_UINT64_C2(0xEA157514, 0x3CF97226), RAPIDJSON_UINT64_C2(0xF52D09D7, 0x1A3293BE), // 1e99
+        RAPIDJSON_UINT64_C2(0x924D692C, 0xA61BE758), RAPIDJSON_UINT64_C2(0x593C2626, 0x705F9C57), // 1e100
+        RAPIDJSON_UINT64_C2(0xB6E0C377, 0xCFA2E12E), RAPIDJSON_UINT64_C2(0x6F8B2FB0, 0x0C77836D), // 1e101
+        RAPIDJSON_UINT64_C2(0xE498F455, 0xC38B997A), RAPIDJSON_UINT64_C2(0x0B6DFB9C, 0x0F956448), // 1e102
+        RAPIDJSON_UINT64_C2(0x8EDF98B5, 0x9A373FEC), RAPIDJSON_UINT64_C2(0x4724BD41, 0x89BD5EAD), // 1e103
+        RAPIDJSON_UINT64_C2(0xB2977EE3, 0x00C50FE7), RAPIDJSON_UINT64_C2(0x58EDEC91, 0xEC2CB658), // 1e104
+        RAPIDJSON_UINT64_C2(0xDF3D5E9B, 0xC0F653E1), RAPIDJSON_UINT64_C2(0x2F2967B6, 0x6737E3EE), // 1e105
+        RAPIDJSON_UINT64_C2(0x8B865B21, 0x5899F46C), RAPIDJSON_UINT64_C2(0xBD79E0D2, 0x0082EE75), // 1e106
+        RAPIDJSON_UINT64_C2(0xAE67F1E9, 0xAEC07187), RAPIDJSON_UINT64_C2(0xECD85906, 0x80A3AA12), // 1e107
+        RAPIDJSON_UINT64_C2(0xDA01EE64, 0x1A708DE9), RAPIDJSON_UINT64_C2(0xE80E6F48, 0x20CC9496), // 1e108
+        RAPIDJSON_UINT64_C2(0x884134FE, 0x908658B2), RAPIDJSON_UINT64_C2(0x3109058D, 0x147FDCDE), // 1e109
+        RAPIDJSON_UINT64_C2(0xAA51823E, 0x34A7EEDE), RAPIDJSON_UINT64_C2(0xBD4B46F0, 0x599FD416), // 1e110
+        RAPIDJSON_UINT64_C2(0xD4E5E2CD, 0xC1D1EA96), RAPIDJSON_UINT64_C2(0x6C9E18AC, 0x7007C91B), // 1e111
+        RAPIDJSON_UINT64_C2(0x850FADC0, 0x9923329E), RAPIDJSON_UINT64_C2(0x03E2CF6B, 0xC604DDB1), // 1e112
+        RAPIDJSON_UINT64_C2(0xA6539930, 0xBF6BFF45), RAPIDJSON_UINT64_C2(0x84DB8346, 0xB786151D), // 1e113
+        RAPIDJSON_UINT64_C2(0xCFE87F7C, 0xEF46FF16), RAPIDJSON_UINT64_C2(0xE6126418, 0x65679A64), // 1e114
+        RAPIDJSON_UINT64_C2(0x81F14FAE, 0x158C5F6E), RAPIDJSON_UINT64_C2(0x4FCB7E8F, 0x3F60C07F), // 1e115
+        RAPIDJSON_UINT64_C2(0xA26DA399, 0x9AEF7749), RAPIDJSON_UINT64_C2(0xE3BE5E33, 0x0F38F09E), // 1e116
+        RAPIDJSON_UINT64_C2(0xCB090C80, 0x01AB551C), RAPIDJSON_UINT64_C2(0x5CADF5BF, 0xD3072CC6), // 1e117
+        RAPIDJSON_UINT64_C2(0xFDCB4FA0, 0x02162A63), RAPIDJSON_UINT64_C2(0x73D9732F, 0xC7C8F7F7), // 1e118
+        RAPIDJSON_UINT64_C2(0x9E9F11C4, 0x014DDA7E), RAPIDJSON_UINT64_C2(0x2867E7FD, 0xDCDD9AFB), // 1e119
+        RAPIDJSON_UINT64_C2(0xC646D635, 0x01A1511D), RAPIDJSON_UINT64_C2(0xB281E1FD, 0x541501B9), // 1e120
+        RAPIDJSON_UINT64_C2(0xF7D88BC2, 0x4209A565), RAPIDJSON_UINT64_C2(0x1F225A7C, 0xA91A4227), // 1e121
+        RAPIDJSON_UINT64_C2(0x9AE75759, 0x6946075F), RAPIDJSON_UINT64_C2(0x3375788D, 0xE9B06959), // 1e122
+        RAPIDJSON_UINT64_C2(0xC1A12D2F, 0xC3978937), RAPIDJSON_UINT64_C2(0x0052D6B1, 0x641C83AF), // 1e123
+        RAPIDJSON_UINT64_C2(0xF209787B, 0xB47D6B84), RAPIDJSON_UINT64_C2(0xC0678C5D, 0xBD23A49B), // 1e124
+        RAPIDJSON_UINT64_C2(0x9745EB4D, 0x50CE6332), RAPIDJSON_UINT64_C2(0xF840B7BA, 0x963646E1), // 1e125
+        RAPIDJSON_UINT64_C2(0xBD176620, 0xA501FBFF), RAPIDJSON_UINT64_C2(0xB650E5A9, 0x3BC3D899), // 1e126
+        RAPIDJSON_UINT64_C2(0xEC5D3FA8, 0xCE427AFF), RAPIDJSON_UINT64_C2(0xA3E51F13, 0x8AB4CEBF), // 1e127
+        RAPIDJSON_UINT64_C2(0x93BA47C9, 0x80E98CDF), RAPIDJSON_UINT64_C2(0xC66F336C, 0x36B10138), // 1e128
+        RAPIDJSON_UINT64_C2(0xB8A8D9BB, 0xE123F017), RAPIDJSON_UINT64_C2(0xB80B0047, 0x445D4185), // 1e129
+        RAPIDJSON_UINT64_C2(0xE6D3102A, 0xD96CEC1D), RAPIDJSON_UINT64_C2(0xA60DC059, 0x157491E6), // 1e130
+        RAPIDJSON_UINT64_C2(0x9043EA1A, 0xC7E41392), RAPIDJSON_UINT64_C2(0x87C89837, 0xAD68DB30), // 1e131
+        RAPIDJSON_UINT64_C2(0xB454E4A1, 0x79DD1877), RAPIDJSON_UINT64_C2(0x29BABE45, 0x98C311FC), // 1e132
+        RAPIDJSON_UINT64_C2(0xE16A1DC9, 0xD8545E94), RAPIDJSON_UINT64_C2(0xF4296DD6, 0xFEF3D67B), // 1e133
+        RAPIDJSON_UINT64_C2(0x8CE2529E, 0x2734BB1D), RAPIDJSON_UINT64_C2(0x1899E4A6, 0x5F58660D), // 1e134
+        RAPIDJSON_UINT64_C2(0xB01AE745, 0xB101E9E4), RAPIDJSON_UINT64_C2(0x5EC05DCF, 0xF72E7F90), // 1e135
+        RAPIDJSON_UINT64_C2(0xDC21A117, 0x1D42645D), RAPIDJSON_UINT64_C2(0x76707543, 0xF4FA1F74), // 1e136
+        RAPIDJSON_UINT64_C2(0x899504AE, 0x72497EBA), RAPIDJSON_UINT64_C2(0x6A06494A, 0x791C53A9), // 1e137
+        RAPIDJSON_UINT64_C2(0xABFA45DA, 0x0EDBDE69), RAPIDJSON_UINT64_C2(0x0487DB9D, 0x17636893), // 1e138
+        RAPIDJSON_UINT64_C2(0xD6F8D750, 0x9292D603), RAPIDJSON_UINT64_C2(0x45A9D284, 0x5D3C42B7), // 1e139
+        RAPIDJSON_UINT64_C2(0x865B8692, 0x5B9BC5C2), RAPIDJSON_UINT64_C2(0x0B8A2392, 0xBA45A9B3), // 1e140
+        RAPIDJSON_UINT64_C2(0xA7F26836, 0xF282B732), RAPIDJSON_UINT64_C2(0x8E6CAC77, 0x68D7141F), // 1e141
+        RAPIDJSON_UINT64_C2(0xD1EF0244, 0xAF2364FF), RAPIDJSON_UINT64_C2(0x3207D795, 0x430CD927), // 1e142
+        RAPIDJSON_UINT64_C2(0x8335616A, 0xED761F1F), RAPIDJSON_UINT64_C2(0x7F44E6BD, 0x49E807B9), // 1e143
+        RAPIDJSON_UINT64_C2(0xA402B9C5, 0xA8D3A6E7), RAPIDJSON_UINT64_C2(0x5F16206C, 0x9C6209A7), // 1e144
+        RAPIDJSON_UINT64_C2(0xCD036837, 0x130890A1), RAPIDJSON_UINT64_C2(0x36DBA887, 0xC37A8C10), // 1e145
+        RAPIDJSON_UINT64_C2(0x80222122, 0x6BE55A64), RAPIDJSON_UINT64_C2(0xC2494954, 0xDA2C978A), // 1e146
+        RAPIDJSON_UINT64_C2(0xA02AA96B, 0x06DEB0FD), RAPIDJSON_UINT64_C2(0xF2DB9BAA, 0x10B7BD6D), // 1e147
+        RAPIDJSON_UINT64_C2(0xC83553C5, 0xC8965D3D), RAPIDJSON_UINT64_C2(0x6F928294, 0x94E5ACC8), // 1e148
+        RAPIDJSON_UINT64_C2(0xFA42A8B7, 0x3ABBF48C), RAPIDJSON_UINT64_C2(0xCB772339, 0xBA1F17FA), // 1e149
+        RAPIDJSON_UINT64_C2(0x9C69A972, 0x84B578D7), RAPIDJSON_UINT64_C2(0xFF2A7604, 0x14536EFC), // 1e150
+        RAPIDJSON_UINT64_C2(0xC38413CF, 0x25E2D70D), RAPIDJSON_UINT64_C2(0xFEF51385, 0x19684ABB), // 1e151
+        RAPIDJSON_UINT64_C2(0xF46518C2, 0xEF5B8CD1), RAPIDJSON_UINT64_C2(0x7EB25866, 0x5FC25D6A), // 1e152
+        RAPIDJSON_UINT64_C2(0x98BF2F79, 0xD5993802), RAPIDJSON_UINT64_C2(0xEF2F773F, 0xFBD97A62), // 1e153
+        RAPIDJSON_UINT64_C2(0xBEEEFB58, 0x4AFF8603), RAPIDJSON_UINT64_C2(0xAAFB550F, 0xFACFD8FB), // 1e154
+        RAPIDJSON_UINT64_C2(0xEEAABA2E, 0x5DBF6784), RAPIDJSON_UINT64_C2(0x95BA2A53, 0xF983CF39), // 1e155
+        RAPIDJSON_UINT64_C2(0x952AB45C, 0xFA97A0B2), RAPIDJSON_UINT64_C2(0xDD945A74, 0x7BF26184), // 1e156
+        RAPIDJSON_UINT64_C2(0xBA756174, 0x393D88DF), RAPIDJSON_UINT64_C2(0x94F97111, 0x9AEEF9E5), // 1e157
+        RAPIDJSON_UINT64_C2(0xE912B9D1, 0x478CEB17), RAPIDJSON_UINT64_C2(0x7A37CD56, 0x01AAB85E), // 1e158
+        RAPIDJSON_UINT64_C2(0x91ABB422, 0xCCB812EE), RAPIDJSON_UINT64_C2(0xAC62E055, 0xC10AB33B), // 1e159
+        RAPIDJSON_UINT64_C2(0xB616A12B, 0x7FE617AA), RAPIDJSON_UINT64_C2(0x577B986B, 0x314D600A), // 1e160
+        RAPIDJSON_UINT64_C2(0xE39C4976, 0x5FDF9D94), RAPIDJSON_UINT64_C2(0xED5A7E85, 0xFDA0B80C), // 1e161
+        RAPIDJSON_UINT64_C2(0x8E41ADE9, 0xFBEBC27D), RAPIDJSON_UINT64_C2(0x14588F13, 0xBE847308), // 1e162
+        RAPIDJSON_UINT64_C2(0xB1D21964, 0x7AE6B31C), RAPIDJSON_UINT64_C2(0x596EB2D8, 0xAE258FC9), // 1e163
+        RAPIDJSON_UINT64_C2(0xDE469FBD, 0x99A05FE3), RAPIDJSON_UINT64_C2(0x6FCA5F8E, 0xD9AEF3BC), // 1e164
+        RAPIDJSON_UINT64_C2(0x8AEC23D6, 0x80043BEE), RAPIDJSON_UINT64_C2(0x25DE7BB9, 0x480D5855), // 1e165
+        RAPIDJSON_UINT64_C2(0xADA72CCC, 0x20054AE9), RAPIDJSON_UINT64_C2(0xAF561AA7, 0x9A10AE6B), // 1e166
+        RAPIDJSON_UINT64_C2(0xD910F7FF, 0x28069DA4), RAPIDJSON_UINT64_C2(0x1B2BA151, 0x8094DA05), // 1e167
+        RAPIDJSON_UINT64_C2(0x87AA9AFF, 0x79042286), RAPIDJSON_UINT64_C2(0x90FB44D2, 0xF05D0843), // 1e168
+        RAPIDJSON_UINT64_C2(0xA99541BF, 0x57452B28), RAPIDJSON_UINT64_C2(0x353A1607, 0xAC744A54), // 1e169
+        RAPIDJSON_UINT64_C2(0xD3FA922F, 0x2D1675F2), RAPIDJSON_UINT64_C2(0x42889B89, 0x97915CE9), // 1e170
+        RAPIDJSON_UINT64_C2(0x847C9B5D, 0x7C2E09B7), RAPIDJSON_UINT64_C2(0x69956135, 0xFEBADA12), // 1e171
+        RAPIDJSON_UINT64_C2(0xA59BC234, 0xDB398C25), RAPIDJSON_UINT64_C2(0x43FAB983, 0x7E699096), // 1e172
+        RAPIDJSON_UINT64_C2(0xCF02B2C2, 0x1207EF2E), RAPIDJSON_UINT64_C2(0x94F967E4, 0x5E03F4BC), // 1e173
+        RAPIDJSON_UINT64_C2(0x8161AFB9, 0x4B44F57D), RAPIDJSON_UINT64_C2(0x1D1BE0EE, 0xBAC278F6), // 1e174
+        RAPIDJSON_UINT64_C2(0xA1BA1BA7, 0x9E1632DC), RAPIDJSON_UINT64_C2(0x6462D92A, 0x69731733), // 1e175
+        RAPIDJSON_UINT64_C2(0xCA28A291, 0x859BBF93), RAPIDJSON_UINT64_C2(0x7D7B8F75, 0x03CFDCFF), // 1e176
+        RAPIDJSON_UINT64_C2(0xFCB2CB35, 0xE702AF78), RAPIDJSON_UINT64_C2(0x5CDA7352, 0x44C3D43F), // 1e177
+        RAPIDJSON_UINT64_C2(0x9DEFBF01, 0xB061ADAB), RAPIDJSON_UINT64_C2(0x3A088813, 0x6AFA64A8), // 1e178
+        RAPIDJSON_UINT64_C2(0xC56BAEC2, 0x1C7A1916), RAPIDJSON_UINT64_C2(0x088AAA18, 0x45B8FDD1), // 1e179
+        RAPIDJSON_UINT64_C2(0xF6C69A72, 0xA3989F5B), RAPIDJSON_UINT64_C2(0x8AAD549E, 0x57273D46), // 1e180
+        RAPIDJSON_UINT64_C2(0x9A3C2087, 0xA63F6399), RAPIDJSON_UINT64_C2(0x36AC54E2, 0xF678864C), // 1e181
+        RAPIDJSON_UINT64_C2(0xC0CB28A9, 0x8FCF3C7F), RAPIDJSON_UINT64_C2(0x84576A1B, 0xB416A7DE), // 1e182
+        RAPIDJSON_UINT64_C2(0xF0FDF2D3, 0xF3C30B9F), RAPIDJSON_UINT64_C2(0x656D44A2, 0xA11C51D6), // 1e183
+        RAPIDJSON_UINT64_C2(0x969EB7C4, 0x7859E743), RAPIDJSON_UINT64_C2(0x9F644AE5, 0xA4B1B326), // 1e184
+        RAPIDJSON_UINT64_C2(0xBC4665B5, 0x96706114), RAPIDJSON_UINT64_C2(0x873D5D9F, 0x0DDE1FEF), // 1e185
+        RAPIDJSON_UINT64_C2(0xEB57FF22, 0xFC0C7959), RAPIDJSON_UINT64_C2(0xA90CB506, 0xD155A7EB), // 1e186
+        RAPIDJSON_UINT64_C2(0x9316FF75, 0xDD87CBD8), RAPIDJSON_UINT64_C2(0x09A7F124, 0x42D588F3), // 1e187
+        RAPIDJSON_UINT64_C2(0xB7DCBF53, 0x54E9BECE), RAPIDJSON_UINT64_C2(0x0C11ED6D, 0x538AEB30), // 1e188
+        RAPIDJSON_UINT64_C2(0xE5D3EF28, 0x2A242E81), RAPIDJSON_UINT64_C2(0x8F1668C8, 0xA86DA5FB), // 1e189
+        RAPIDJSON_UINT64_C2(0x8FA47579, 0x1A569D10), RAPIDJSON_UINT64_C2(0xF96E017D, 0x694487BD), // 1e190
+        RAPIDJSON_UINT64_C2(0xB38D92D7, 0x60EC4455), RAPIDJSON_UINT64_C2(0x37C981DC, 0xC395A9AD), // 1e191
+        RAPIDJSON_UINT64_C2(0xE070F78D, 0x3927556A), RAPIDJSON_UINT64_C2(0x85BBE253, 0xF47B1418), // 1e192
+        RAPIDJSON_UINT64_C2(0x8C469AB8, 0x43B89562), RAPIDJSON_UINT64_C2(0x93956D74, 0x78CCEC8F), // 1e193
+        RAPIDJSON_UINT64_C2(0xAF584166, 0x54A6BABB), RAPIDJSON_UINT64_C2(0x387AC8D1, 0x970027B3), // 1e194
+        RAPIDJSON_UINT64_C2(0xDB2E51BF, 0xE9D0696A), RAPIDJSON_UINT64_C2(0x06997B05, 0xFCC0319F), // 1e195
+        RAPIDJSON_UINT64_C2(0x88FCF317, 0xF22241E2), RAPIDJSON_UINT64_C2(0x441FECE3, 0xBDF81F04), // 1e196
+        RAPIDJSON_UINT64_C2(0xAB3C2FDD, 0xEEAAD25A), RAPIDJSON_UINT64_C2(0xD527E81C, 0xAD7626C4), // 1e197
+        RAPIDJSON_UINT64_C2(0xD60B3BD5, 0x6A5586F1), RAPIDJSON_UINT64_C2(0x8A71E223, 0xD8D3B075), // 1e198
+        RAPIDJSON_UINT64_C2(0x85C70565, 0x62757456), RAPIDJSON_UINT64_C2(0xF6872D56, 0x67844E4A), // 1e199
+        RAPIDJSON_UINT64_C2(0xA738C6BE, 0xBB12D16C), RAPIDJSON_UINT64_C2(0xB428F8AC, 0x016561DC), // 1e200
+        RAPIDJSON_UINT64_C2(0xD106F86E, 0x69D785C7), RAPIDJSON_UINT64_C2(0xE13336D7, 0x01BEBA53), // 1e201
+        RAPIDJSON_UINT64_C2(0x82A45B45, 0x0226B39C), RAPIDJSON_UINT64_C2(0xECC00246, 0x61173474), // 1e202
+        RAPIDJSON_UINT64_C2(0xA34D7216, 0x42B06084), RAPIDJSON_UINT64_C2(0x27F002D7, 0xF95D0191), // 1e203
+        RAPIDJSON_UINT64_C2(0xCC20CE9B, 0xD35C78A5), RAPIDJSON_UINT64_C2(0x31EC038D, 0xF7B441F5), // 1e204
+        RAPIDJSON_UINT64_C2(0xFF290242, 0xC83396CE), RAPIDJSON_UINT64_C2(0x7E670471, 0x75A15272), // 1e205
+        RAPIDJSON_UINT64_C2(0x9F79A169, 0xBD203E41), RAPIDJSON_UINT64_C2(0x0F0062C6, 0xE984D387), // 1e206
+        RAPIDJSON_UINT64_C2(0xC75809C4, 0x2C684DD1), RAPIDJSON_UINT64_C2(0x52C07B78, 0xA3E60869), // 1e207
+        RAPIDJSON_UINT64_C2(0xF92E0C35, 0x37826145), RAPIDJSON_UINT64_C2(0xA7709A56, 0xCCDF8A83), // 1e208
+        RAPIDJSON_UINT64_C2(0x9BBCC7A1, 0x42B17CCB), RAPIDJSON_UINT64_C2(0x88A66076, 0x400BB692), // 1e209
+        RAPIDJSON_UINT64_C2(0xC2ABF989, 0x935DDBFE), RAPIDJSON_UINT64_C2(0x6ACFF893, 0xD00EA436), // 1e210
+        RAPIDJSON_UINT64_C2(0xF356F7EB, 0xF83552FE), RAPIDJSON_UINT64_C2(0x0583F6B8, 0xC4124D44), // 1e211
+        RAPIDJSON_UINT64_C2(0x98165AF3, 0x7B2153DE), RAPIDJSON_UINT64_C2(0xC3727A33, 0x7A8B704B), // 1e212
+        RAPIDJSON_UINT64_C2(0xBE1BF1B0, 0x59E9A8D6), RAPIDJSON_UINT64_C2(0x744F18C0, 0x592E4C5D), // 1e213
+        RAPIDJSON_UINT64_C2(0xEDA2EE1C, 0x7064130C), RAPIDJSON_UINT64_C2(0x1162DEF0, 0x6F79DF74), // 1e214
+        RAPIDJSON_UINT64_C2(0x9485D4D1, 0xC63E8BE7), RAPIDJSON_UINT64_C2(0x8ADDCB56, 0x45AC2BA9), // 1e215
+        RAPIDJSON_UINT64_C2(0xB9A74A06, 0x37CE2EE1), RAPIDJSON_UINT64_C2(0x6D953E2B, 0xD7173693), // 1e216
+        RAPIDJSON_UINT64_C2(0xE8111C87, 0xC5C1BA99), RAPIDJSON_UINT64_C2(0xC8FA8DB6, 0xCCDD0438), // 1e217
+        RAPIDJSON_UINT64_C2(0x910AB1D4, 0xDB9914A0), RAPIDJSON_UINT64_C2(0x1D9C9892, 0x400A22A3), // 1e218
+        RAPIDJSON_UINT64_C2(0xB54D5E4A, 0x127F59C8), RAPIDJSON_UINT64_C2(0x2503BEB6, 0xD00CAB4C), // 1e219
+        RAPIDJSON_UINT64_C2(0xE2A0B5DC, 0x971F303A), RAPIDJSON_UINT64_C2(0x2E44AE64, 0x840FD61E), // 1e220
+        RAPIDJSON_UINT64_C2(0x8DA471A9, 0xDE737E24), RAPIDJSON_UINT64_C2(0x5CEAECFE, 0xD289E5D3), // 1e221
+        RAPIDJSON_UINT64_C2(0xB10D8E14, 0x56105DAD), RAPIDJSON_UINT64_C2(0x7425A83E, 0x872C5F48), // 1e222
+        RAPIDJSON_UINT64_C2(0xDD50F199, 0x6B947518), RAPIDJSON_UINT64_C2(0xD12F124E, 0x28F7771A), // 1e223
+        RAPIDJSON_UINT64_C2(0x8A5296FF, 0xE33CC92F), RAPIDJSON_UINT64_C2(0x82BD6B70, 0xD99AAA70), // 1e224
+        RAPIDJSON_UINT64_C2(0xACE73CBF, 0xDC0BFB7B), RAPIDJSON_UINT64_C2(0x636CC64D, 0x1001550C), // 1e225
+        RAPIDJSON_UINT64_C2(0xD8210BEF, 0xD30EFA5A), RAPIDJSON_UINT64_C2(0x3C47F7E0, 0x5401AA4F), // 1e226
+        RAPIDJSON_UINT64_C2(0x8714A775, 0xE3E95C78), RAPIDJSON_UINT64_C2(0x65ACFAEC, 0x34810A72), // 1e227
+        RAPIDJSON_UINT64_C2(0xA8D9D153, 0x5CE3B396), RAPIDJSON_UINT64_C2(0x7F1839A7, 0x41A14D0E), // 1e228
+        RAPIDJSON_UINT64_C2(0xD31045A8, 0x341CA07C), RAPIDJSON_UINT64_C2(0x1EDE4811, 0x1209A051), // 1e229
+        RAPIDJSON_UINT64_C2(0x83EA2B89, 0x2091E44D), RAPIDJSON_UINT64_C2(0x934AED0A, 0xAB460433), // 1e230
+        RAPIDJSON_UINT64_C2(0xA4E4B66B, 0x68B65D60), RAPIDJSON_UINT64_C2(0xF81DA84D, 0x56178540), // 1e231
+        RAPIDJSON_UINT64_C2(0xCE1DE406, 0x42E3F4B9), RAPIDJSON_UINT64_C2(0x36251260, 0xAB9D668F), // 1e232
+        RAPIDJSON_UINT64_C2(0x80D2AE83, 0xE9CE78F3), RAPIDJSON_UINT64_C2(0xC1D72B7C, 0x6B42601A), // 1e233
+        RAPIDJSON_UINT64_C2(0xA1075A24, 0xE4421730), RAPIDJSON_UINT64_C2(0xB24CF65B, 0x8612F820), // 1e234
+        RAPIDJSON_UINT64_C2(0xC94930AE, 0x1D529CFC), RAPIDJSON_UINT64_C2(0xDEE033F2, 0x6797B628), // 1e235
+        RAPIDJSON_UINT64_C2(0xFB9B7CD9, 0xA4A7443C), RAPIDJSON_UINT64_C2(0x169840EF, 0x017DA3B2), // 1e236
+        RAPIDJSON_UINT64_C2(0x9D412E08, 0x06E88AA5), RAPIDJSON_UINT64_C2(0x8E1F2895, 0x60EE864F), // 1e237
+        RAPIDJSON_UINT64_C2(0xC491798A, 0x08A2AD4E), RAPIDJSON_UINT64_C2(0xF1A6F2BA, 0xB92A27E3), // 1e238
+        RAPIDJSON_UINT64_C2(0xF5B5D7EC, 0x8ACB58A2), RAPIDJSON_UINT64_C2(0xAE10AF69, 0x6774B1DC), // 1e239
+        RAPIDJSON_UINT64_C2(0x9991A6F3, 0xD6BF1765), RAPIDJSON_UINT64_C2(0xACCA6DA1, 0xE0A8EF2A), // 1e240
+        RAPIDJSON_UINT64_C2(0xBFF610B0, 0xCC6EDD3F), RAPIDJSON_UINT64_C2(0x17FD090A, 0x58D32AF4), // 1e241
+        RAPIDJSON_UINT64_C2(0xEFF394DC, 0xFF8A948E), RAPIDJSON_UINT64_C2(0xDDFC4B4C, 0xEF07F5B1), // 1e242
+        RAPIDJSON_UINT64_C2(0x95F83D0A, 0x1FB69CD9), RAPIDJSON_UINT64_C2(0x4ABDAF10, 0x1564F98F), // 1e243
+        RAPIDJSON_UINT64_C2(0xBB764C4C, 0xA7A4440F), RAPIDJSON_UINT64_C2(0x9D6D1AD4, 0x1ABE37F2), // 1e244
+        RAPIDJSON_UINT64_C2(0xEA53DF5F, 0xD18D5513), RAPIDJSON_UINT64_C2(0x84C86189, 0x216DC5EE), // 1e245
+        RAPIDJSON_UINT64_C2(0x92746B9B, 0xE2F8552C), RAPIDJSON_UINT64_C2(0x32FD3CF5, 0xB4E49BB5), // 1e246
+        RAPIDJSON_UINT64_C2(0xB7118682, 0xDBB66A77), RAPIDJSON_UINT64_C2(0x3FBC8C33, 0x221DC2A2), // 1e247
+        RAPIDJSON_UINT64_C2(0xE4D5E823, 0x92A40515), RAPIDJSON_UINT64_C2(0x0FABAF3F, 0xEAA5334B), // 1e248
+        RAPIDJSON_UINT64_C2(0x8F05B116, 0x3BA6832D), RAPIDJSON_UINT64_C2(0x29CB4D87, 0xF2A7400F), // 1e249
+        RAPIDJSON_UINT64_C2(0xB2C71D5B, 0xCA9023F8), RAPIDJSON_UINT64_C2(0x743E20E9, 0xEF511013), // 1e250
+        RAPIDJSON_UINT64_C2(0xDF78E4B2, 0xBD342CF6), RAPIDJSON_UINT64_C2(0x914DA924, 0x6B255417), // 1e251
+        RAPIDJSON_UINT64_C2(0x8BAB8EEF, 0xB6409C1A), RAPIDJSON_UINT64_C2(0x1AD089B6, 0xC2F7548F), // 1e252
+        RAPIDJSON_UINT64_C2(0xAE9672AB, 0xA3D0C320), RAPIDJSON_UINT64_C2(0xA184AC24, 0x73B529B2), // 1e253
+        RAPIDJSON_UINT64_C2(0xDA3C0F56, 0x8CC4F3E8), RAPIDJSON_UINT64_C2(0xC9E5D72D, 0x90A2741F), // 1e254
+        RAPIDJSON_UINT64_C2(0x88658996, 0x17FB1871), RAPIDJSON_UINT64_C2(0x7E2FA67C, 0x7A658893), // 1e255
+        RAPIDJSON_UINT64_C2(0xAA7EEBFB, 0x9DF9DE8D), RAPIDJSON_UINT64_C2(0xDDBB901B, 0x98FEEAB8), // 1e256
+        RAPIDJSON_UINT64_C2(0xD51EA6FA, 0x85785631), RAPIDJSON_UINT64_C2(0x552A7422, 0x7F3EA566), // 1e257
+        RAPIDJSON_UINT64_C2(0x8533285C, 0x936B35DE), RAPIDJSON_UINT64_C2(0xD53A8895, 0x8F872760), // 1e258
+        RAPIDJSON_UINT64_C2(0xA67FF273, 0xB8460356), RAPIDJSON_UINT64_C2(0x8A892ABA, 0xF368F138), // 1e259
+        RAPIDJSON_UINT64_C2(0xD01FEF10, 0xA657842C), RAPIDJSON_UINT64_C2(0x2D2B7569, 0xB0432D86), // 1e260
+        RAPIDJSON_UINT64_C2(0x8213F56A, 0x67F6B29B), RAPIDJSON_UINT64_C2(0x9C3B2962, 0x0E29FC74), // 1e261
+        RAPIDJSON_UINT64_C2(0xA298F2C5, 0x01F45F42), RAPIDJSON_UINT64_C2(0x8349F3BA, 0x91B47B90), // 1e262
+        RAPIDJSON_UINT64_C2(0xCB3F2F76, 0x42717713), RAPIDJSON_UINT64_C2(0x241C70A9, 0x36219A74), // 1e263
+        RAPIDJSON_UINT64_C2(0xFE0EFB53, 0xD30DD4D7), RAPIDJSON_UINT64_C2(0xED238CD3, 0x83AA0111), // 1e264
+        RAPIDJSON_UINT64_C2(0x9EC95D14, 0x63E8A506), RAPIDJSON_UINT64_C2(0xF4363804, 0x324A40AB), // 1e265
+        RAPIDJSON_UINT64_C2(0xC67BB459, 0x7CE2CE48), RAPIDJSON_UINT64_C2(0xB143C605, 0x3EDCD0D6), // 1e266
+        RAPIDJSON_UINT64_C2(0xF81AA16F, 0xDC1B81DA), RAPIDJSON_UINT64_C2(0xDD94B786, 0x8E94050B), // 1e267
+        RAPIDJSON_UINT64_C2(0x9B10A4E5, 0xE9913128), RAPIDJSON_UINT64_C2(0xCA7CF2B4, 0x191C8327), // 1e268
+        RAPIDJSON_UINT64_C2(0xC1D4CE1F, 0x63F57D72), RAPIDJSON_UINT64_C2(0xFD1C2F61, 0x1F63A3F1), // 1e269
+        RAPIDJSON_UINT64_C2(0xF24A01A7, 0x3CF2DCCF), RAPIDJSON_UINT64_C2(0xBC633B39, 0x673C8CED), // 1e270
+        RAPIDJSON_UINT64_C2(0x976E4108, 0x8617CA01), RAPIDJSON_UINT64_C2(0xD5BE0503, 0xE085D814), // 1e271
+        RAPIDJSON_UINT64_C2(0xBD49D14A, 0xA79DBC82), RAPIDJSON_UINT64_C2(0x4B2D8644, 0xD8A74E19), // 1e272
+        RAPIDJSON_UINT64_C2(0xEC9C459D, 0x51852BA2), RAPIDJSON_UINT64_C2(0xDDF8E7D6, 0x0ED1219F), // 1e273
+        RAPIDJSON_UINT64_C2(0x93E1AB82, 0x52F33B45), RAPIDJSON_UINT64_C2(0xCABB90E5, 0xC942B504), // 1e274
+        RAPIDJSON_UINT64_C2(0xB8DA1662, 0xE7B00A17), RAPIDJSON_UINT64_C2(0x3D6A751F, 0x3B936244), // 1e275
+        RAPIDJSON_UINT64_C2(0xE7109BFB, 0xA19C0C9D), RAPIDJSON_UINT64_C2(0x0CC51267, 0x0A783AD5), // 1e276
+        RAPIDJSON_UINT64_C2(0x906A617D, 0x450187E2), RAPIDJSON_UINT64_C2(0x27FB2B80, 0x668B24C6), // 1e277
+        RAPIDJSON_UINT64_C2(0xB484F9DC, 0x9641E9DA), RAPIDJSON_UINT64_C2(0xB1F9F660, 0x802DEDF7), // 1e278
+        RAPIDJSON_UINT64_C2(0xE1A63853, 0xBBD26451), RAPIDJSON_UINT64_C2(0x5E7873F8, 0xA0396974), // 1e279
+        RAPIDJSON_UINT64_C2(0x8D07E334, 0x55637EB2), RAPIDJSON_UINT64_C2(0xDB0B487B, 0x6423E1E9), // 1e280
+        RAPIDJSON_UINT64_C2(0xB049DC01, 0x6ABC5E5F), RAPIDJSON_UINT64_C2(0x91CE1A9A, 0x3D2CDA63), // 1e281
+        RAPIDJSON_UINT64_C2(0xDC5C5301, 0xC56B75F7), RAPIDJSON_UINT64_C2(0x7641A140, 0xCC7810FC), // 1e282
+        RAPIDJSON_UINT64_C2(0x89B9B3E1, 0x1B6329BA), RAPIDJSON_UINT64_C2(0xA9E904C8, 0x7FCB0A9E), // 1e283
+        RAPIDJSON_UINT64_C2(0xAC2820D9, 0x623BF429), RAPIDJSON_UINT64_C2(0x546345FA, 0x9FBDCD45), // 1e284
+        RAPIDJSON_UINT64_C2(0xD732290F, 0xBACAF133), RAPIDJSON_UINT64_C2(0xA97C1779, 0x47AD4096), // 1e285
+        RAPIDJSON_UINT64_C2(0x867F59A9, 0xD4BED6C0), RAPIDJSON_UINT64_C2(0x49ED8EAB, 0xCCCC485E), // 1e286
+        RAPIDJSON_UINT64_C2(0xA81F3014, 0x49EE8C70), RAPIDJSON_UINT64_C2(0x5C68F256, 0xBFFF5A75), // 1e287
+        RAPIDJSON_UINT64_C2(0xD226FC19, 0x5C6A2F8C), RAPIDJSON_UINT64_C2(0x73832EEC, 0x6FFF3112), // 1e288
+        RAPIDJSON_UINT64_C2(0x83585D8F, 0xD9C25DB7), RAPIDJSON_UINT64_C2(0xC831FD53, 0xC5FF7EAC), // 1e289
+        RAPIDJSON_UINT64_C2(0xA42E74F3, 0xD032F525), RAPIDJSON_UINT64_C2(0xBA3E7CA8, 0xB77F5E56), // 1e290
+        RAPIDJSON_UINT64_C2(0xCD3A1230, 0xC43FB26F), RAPIDJSON_UINT64_C2(0x28CE1BD2, 0xE55F35EC), // 1e291
+        RAPIDJSON_UINT64_C2(0x80444B5E, 0x7AA7CF85), RAPIDJSON_UINT64_C2(0x7980D163, 0xCF5B81B4), // 1e292
+        RAPIDJSON_UINT64_C2(0xA0555E36, 0x1951C366), RAPIDJSON_UINT64_C2(0xD7E105BC, 0xC3326220), // 1e293
+        RAPIDJSON_UINT64_C2(0xC86AB5C3, 0x9FA63440), RAPIDJSON_UINT64_C2(0x8DD9472B, 0xF3FEFAA8), // 1e294
+        RAPIDJSON_UINT64_C2(0xFA856334, 0x878FC150), RAPIDJSON_UINT64_C2(0xB14F98F6, 0xF0FEB952), // 1e295
+        RAPIDJSON_UINT64_C2(0x9C935E00, 0xD4B9D8D2), RAPIDJSON_UINT64_C2(0x6ED1BF9A, 0x569F33D4), // 1e296
+        RAPIDJSON_UINT64_C2(0xC3B83581, 0x09E84F07), RAPIDJSON_UINT64_C2(0x0A862F80, 0xEC4700C9), // 1e297
+        RAPIDJSON_UINT64_C2(0xF4A642E1, 0x4C6262C8), RAPIDJSON_UINT64_C2(0xCD27BB61, 0x2758C0FB), // 1e298
+        RAPIDJSON_UINT64_C2(0x98E7E9CC, 0xCFBD7DBD), RAPIDJSON_UINT64_C2(0x8038D51C, 0xB897789D), // 1e299
+        RAPIDJSON_UINT64_C2(0xBF21E440, 0x03ACDD2C), RAPIDJSON_UINT64_C2(0xE0470A63, 0xE6BD56C4), // 1e300
+        RAPIDJSON_UINT64_C2(0xEEEA5D50, 0x04981478), RAPIDJSON_UINT64_C2(0x1858CCFC, 0xE06CAC75), // 1e301
+        RAPIDJSON_UINT64_C2(0x95527A52, 0x02DF0CCB), RAPIDJSON_UINT64_C2(0x0F37801E, 0x0C43EBC9), // 1e302
+        RAPIDJSON_UINT64_C2(0xBAA718E6, 0x8396CFFD), RAPIDJSON_UINT64_C2(0xD3056025, 0x8F54E6BB), // 1e303
+        RAPIDJSON_UINT64_C2(0xE950DF20, 0x247C83FD), RAPIDJSON_UINT64_C2(0x47C6B82E, 0xF32A206A), // 1e304
+        RAPIDJSON_UINT64_C2(0x91D28B74, 0x16CDD27E), RAPIDJSON_UINT64_C2(0x4CDC331D, 0x57FA5442), // 1e305
+        RAPIDJSON_UINT64_C2(0xB6472E51, 0x1C81471D), RAPIDJSON_UINT64_C2(0xE0133FE4, 0xADF8E953), // 1e306
+        RAPIDJSON_UINT64_C2(0xE3D8F9E5, 0x63A198E5), RAPIDJSON_UINT64_C2(0x58180FDD, 0xD97723A7), // 1e307
+        RAPIDJSON_UINT64_C2(0x8E679C2F, 0x5E44FF8F), RAPIDJSON_UINT64_C2(0x570F09EA, 0xA7EA7649), // 1e308
+        RAPIDJSON_UINT64_C2(0xB201833B, 0x35D63F73), RAPIDJSON_UINT64_C2(0x2CD2CC65, 0x51E513DB), // 1e309
+        RAPIDJSON_UINT64_C2(0xDE81E40A, 0x034BCF4F), RAPIDJSON_UINT64_C2(0xF8077F7E, 0xA65E58D2), // 1e310
+        RAPIDJSON_UINT64_C2(0x8B112E86, 0x420F6191), RAPIDJSON_UINT64_C2(0xFB04AFAF, 0x27FAF783), // 1e311
+        RAPIDJSON_UINT64_C2(0xADD57A27, 0xD29339F6), RAPIDJSON_UINT64_C2(0x79C5DB9A, 0xF1F9B564), // 1e312
+        RAPIDJSON_UINT64_C2(0xD94AD8B1, 0xC7380874), RAPIDJSON_UINT64_C2(0x18375281, 0xAE7822BD), // 1e313
+        RAPIDJSON_UINT64_C2(0x87CEC76F, 0x1C830548), RAPIDJSON_UINT64_C2(0x8F229391, 0x0D0B15B6), // 1e314
+        RAPIDJSON_UINT64_C2(0xA9C2794A, 0xE3A3C69A), RAPIDJSON_UINT64_C2(0xB2EB3875, 0x504DDB23), // 1e315
+        RAPIDJSON_UINT64_C2(0xD433179D, 0x9C8CB841), RAPIDJSON_UINT64_C2(0x5FA60692, 0xA46151EC), // 1e316
+        RAPIDJSON_UINT64_C2(0x849FEEC2, 0x81D7F328), RAPIDJSON_UINT64_C2(0xDBC7C41B, 0xA6BCD334), // 1e317
+        RAPIDJSON_UINT64_C2(0xA5C7EA73, 0x224DEFF3), RAPIDJSON_UINT64_C2(0x12B9B522, 0x906C0801), // 1e318
+        RAPIDJSON_UINT64_C2(0xCF39E50F, 0xEAE16BEF), RAPIDJSON_UINT64_C2(0xD768226B, 0x34870A01), // 1e319
+        RAPIDJSON_UINT64_C2(0x81842F29, 0xF2CCE375), RAPIDJSON_UINT64_C2(0xE6A11583, 0x00D46641), // 1e320
+        RAPIDJSON_UINT64_C2(0xA1E53AF4, 0x6F801C53), RAPIDJSON_UINT64_C2(0x60495AE3, 0xC1097FD1), // 1e321
+        RAPIDJSON_UINT64_C2(0xCA5E89B1, 0x8B602368), RAPIDJSON_UINT64_C2(0x385BB19C, 0xB14BDFC5), // 1e322
+        RAPIDJSON_UINT64_C2(0xFCF62C1D, 0xEE382C42), RAPIDJSON_UINT64_C2(0x46729E03, 0xDD9ED7B6), // 1e323
+        RAPIDJSON_UINT64_C2(0x9E19DB92, 0xB4E31BA9), RAPIDJSON_UINT64_C2(0x6C07A2C2, 0x6A8346D2)  // 1e324
+    };
+    RAPIDJSON_ASSERT(k >= -292 && k <= 324);
+    return &kPow10[2 * (k + 292)];
+}
+
+//! high 64 bits of the 128-bit product, low bits in *lo
+inline uint64_t UMul128(uint64_t a, uint64_t b, uint64_t* lo) {
+#if defined(_MSC_VER) && defined(_M_AMD64)
+    uint64_t h;
+    *lo = _umul128(a, b, &h);
+    return h;
+#elif (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 6)) && defined(__x86_64__)
+    __extension__ typedef unsigned __int128 uint128;
+    uint128 p = static_cast<uint128>(a) * static_cast<uint128>(b);
+    *lo = static_cast<uint64_t>(p);
+    return static_cast<uint64_t>(p >> 64);
+#else
+    const uint64_t M32 = 0xFFFFFFFF;
+    const uint64_t ac = (a >> 32) * (b >> 32);
+    const uint64_t bc = (a & M32) * (b >> 32);
+    const uint64_t ad = (a >> 32) * (b & M32);
+    const uint64_t bd = (a & M32) * (b & M32);
+    const uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+    *lo = (tmp << 32) | (bd & M32);
+    return ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+#endif
+}
+
+//! floor(g * cp / 2^128), rounded to odd when inexact
+inline uint64_t SchubfachRoundToOdd(const uint64_t* g, uint64_t cp) {
+    uint64_t x0, y0;
+    const uint64_t x1 = UMul128(g[1], cp, &x0);
+    const uint64_t y1 = UMul128(g[0], cp, &y0);
+    const uint64_t z = y0 + x1;
+    const uint64_t vbp = y1 + (z < y0 ? 1 : 0);
+    return vbp | (z != 0 ? 1 : 0);
+}
+
+inline void Schubfach(double value, char* buffer, int* length, int* K) {
+    const Double d(value);
+    const uint64_t significand = d.Uint64Value() & RAPIDJSON_UINT64_C2(0x000FFFFF, 0xFFFFFFFF);
+    const int biased_e = static_cast<int>((d.Uint64Value() >> 52) & 0x7FF);
+
+    uint64_t c, digits;
+    int q, k;
+    if (biased_e != 0) {
+        c = significand | RAPIDJSON_UINT64_C2(0x00100000, 0x00000000);
+        q = biased_e - 1075;
+    }
+    else {
+        c = significand;
+        q = -1074;
+    }
+
+    if (q <= 0 && q > -53 && (c & ((uint64_t(1) << -q) - 1)) == 0) {
+        // small integers
+        digits = c >> -q;
+        k = 0;
+    }
+    else {
+        const bool accept = (c & 1) == 0;
+        const bool closer = significand == 0 && biased_e > 1;
+        const uint64_t cbl = 4 * c - 2 + (closer ? 1 : 0);
+        const uint64_t cb = 4 * c;
+        const uint64_t cbr = 4 * c + 2;
+
+        // floor(log10(2^q)) or floor(log10(3/4 * 2^q)), and h in [1, 4]
+        k = (q * 1262611 - (closer ? 524031 : 0)) >> 22;
+        const int h = q + ((-k * 1741647) >> 19) + 1;
+
+        const uint64_t* g = GetSchubfachPow10(-k);
+        const uint64_t vbl = SchubfachRoundToOdd(g, cbl << h);
+        const uint64_t vb = SchubfachRoundToOdd(g, cb << h);
+        const uint64_t vbr = SchubfachRoundToOdd(g, cbr << h);
+        const uint64_t lower = vbl + (accept ? 0 : 1);
+        const uint64_t upper = vbr - (accept ? 0 : 1);
+
+        const uint64_t s = vb / 4;
+        bool done = false;
+        if (s >= 10) {
+            const uint64_t sp = s / 10;
+            const bool up_inside = lower <= 40 * sp;
+            const bool wp_inside = 40 * sp + 40 <= upper;
+            if (up_inside != wp_inside) {
+                digits = sp + (wp_inside ? 1 : 0);
+                k++;
+                done = true;
+            }
+        }
+        if (!done) {
+            const bool u_inside = lower <= 4 * s;
+            const bool w_inside = 4 * s + 4 <= upper;
+            if (u_inside != w_inside)
+                digits = s + (w_inside ? 1 : 0);
+            else {
+                const uint64_t mid = 4 * s + 2;
+                digits = s + ((vb > mid || (vb == mid && (s & 1) != 0)) ? 1 : 0);
+            }
+        }
+    }
+
+    // strip trailing zeros in halving steps instead of one digit at a time
+    while (digits % 100000000 == 0) {
+        digits /= 100000000;
+        k += 8;
+    }
+    if (digits % 10000 == 0) {
+        digits /= 10000;
+        k += 4;
+    }
+    if (digits % 100 == 0) {
+        digits /= 100;
+        k += 2;
+    }
+    if (digits % 10 == 0) {
+        digits /= 10;
+        k++;
+    }
+    *length = static_cast<int>(u64toa(digits, buffer) - buffer);
+    *K = k;
+}
+
 inline char* WriteExponent(int K, char* buffer) {
     if (K < 0) {
         *buffer++ = '-';
@@ -213,7 +963,46 @@ inline char* Prettify(char* buffer, int length, int k, int maxDecimalPlaces) {
     }
 }
 
-inline char* dtoa(double value, char* buffer, int maxDecimalPlaces = 324) {
+//! Rounds the digits buffer[0, length) * 10^K half away from zero to at most maxDecimalPlaces decimal places.
+/*! Trailing zeros are dropped, a carry through all digits leaves "1" at a higher K.
+    \return false if the value rounds to zero.
+*/
+inline bool RoundDecimalPlaces(char* buffer, int* length, int* K, int maxDecimalPlaces) {
+    const int drop = -*K - maxDecimalPlaces;
+    if (drop <= 0)
+        return true;
+    const int keep = *length - drop;
+    if (keep < 0)
+        return false;
+    const bool up = buffer[keep] >= '5';
+    *length = keep;
+    *K += drop;
+    if (up) {
+        int i = keep - 1;
+        while (i >= 0 && buffer[i] == '9')
+            i--;
+        if (i < 0) {
+            // 0.96 -> 1.0
+            buffer[0] = '1';
+            *K += keep;
+            *length = 1;
+        }
+        else {
+            // 0.1296 -> 0.13
+            buffer[i]++;
+            *K += keep - 1 - i;
+            *length = i + 1;
+        }
+        return true;
+    }
+    while (*length > 0 && buffer[*length - 1] == '0') {
+        --*length;
+        ++*K;
+    }
+    return *length > 0;
+}
+
+inline char* dtoa(double value, char* buffer, int maxDecimalPlaces = 324, bool roundDecimalPlaces = false) {
     RAPIDJSON_ASSERT(maxDecimalPlaces >= 1);
     Double d(value);
     if (d.IsZero()) {
@@ -230,7 +1019,17 @@ inline char* dtoa(double value, char* buffer, int maxDecimalPlaces = 324) {
             value = -value;
         }
         int length, K;
+#ifdef RAPIDJSON_DTOA_GRISU2
         Grisu2(value, buffer, &length, &K);
+#else
+        Schubfach(value, buffer, &length, &K);
+#endif
+        if (roundDecimalPlaces && !RoundDecimalPlaces(buffer, &length, &K, maxDecimalPlaces)) {
+            buffer[0] = '0';
+            buffer[1] = '.';
+            buffer[2] = '0';
+            return &buffer[3];
+        }
         return Prettify(buffer, length, K, maxDecimalPlaces);
     }
 }
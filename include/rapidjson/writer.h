@@ -67,6 +67,7 @@ enum WriteFlag {
     kWriteNoFlags = 0,              //!< No flags are set.
     kWriteValidateEncodingFlag = 1, //!< Validate encoding of JSON strings.
     kWriteNanAndInfFlag = 2,        //!< Allow writing of Infinity, -Infinity and NaN.
+    kWriteRoundDecimalPlacesFlag = 4, //!< Round to SetMaxDecimalPlaces() half away from zero instead of truncating.
     kWriteDefaultFlags = RAPIDJSON_WRITE_DEFAULT_FLAGS  //!< Default write flags. Can be customized by defining RAPIDJSON_WRITE_DEFAULT_FLAGS
 };
 
@@ -165,6 +166,9 @@ public:
         writer.EndArray();
         \endcode
 
+        With kWriteRoundDecimalPlacesFlag the shortest representation is rounded half away from zero
+        instead, e.g. 0.12351 gives "0.124" and 0.9999 gives "1.0".
+
         The default setting does not truncate any decimal places. You can restore to this setting by calling
         \code
         writer.SetMaxDecimalPlaces(Writer::kDefaultMaxDecimalPlaces);
@@ -367,7 +371,7 @@ protected:
         }
 
         char buffer[25];
-        char* end = internal::dtoa(d, buffer, maxDecimalPlaces_);
+        char* end = internal::dtoa(d, buffer, maxDecimalPlaces_, (writeFlags & kWriteRoundDecimalPlacesFlag) != 0);
         PutReserve(*os_, static_cast<size_t>(end - buffer));
         for (char* p = buffer; p != end; ++p)
             PutUnsafe(*os_, static_cast<typename OutputStream::Ch>(*p));
@@ -565,7 +569,7 @@ inline bool Writer<StringBuffer>::WriteDouble(double d) {
     }
     
     char *buffer = os_->Push(25);
-    char* end = internal::dtoa(d, buffer, maxDecimalPlaces_);
+    char* end = internal::dtoa(d, buffer, maxDecimalPlaces_, (kWriteDefaultFlags & kWriteRoundDecimalPlacesFlag) != 0);
     os_->Pop(static_cast<size_t>(25 - (end - buffer)));
     return true;
 }
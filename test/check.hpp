@@ -0,0 +1,28 @@
+/**
+ * @file test/check.hpp
+ * @brief Minimal assertion helper shared by the test applications
+ * @details CHECK reports the failing expression with its location and keeps going, main() returns
+ * check_result() so that ctest sees every failure of a run at once.
+ */
+
+#ifndef MJSON_CPP_TEST_CHECK
+#define MJSON_CPP_TEST_CHECK
+
+#include <cstdio>
+
+static int g_failures = 0;
+
+#define CHECK(expr) \
+    do { \
+        if(!(expr)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+            g_failures++; \
+        } \
+    } while(false)
+
+inline int check_result() {
+    if(g_failures != 0) std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
+
+#endif //MJSON_CPP_TEST_CHECK
@@ -0,0 +1,104 @@
+/**
+ * @file test/test_base64.cpp
+ * @brief Base64 typed arrays: the codec against a byte-at-a-time reference, ragged rows in one object
+ */
+
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mjson.hpp"
+#include "check.hpp"
+
+static std::string read_file(const std::string& path) {
+    std::ifstream _file(path, std::ios::binary);
+    std::stringstream _text{};
+    _text << _file.rdbuf();
+    return _text.str();
+}
+
+//! one group of three bytes at a time, as RFC 4648 spells it out
+static std::string reference(const std::vector<unsigned char>& data) {
+    static const char _table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string _text{};
+    for(std::size_t i = 0; i < data.size(); i += 3) {
+        const std::size_t _left = data.size() - i;
+        unsigned v = static_cast<unsigned>(data[i]) << 16;
+        if(_left > 1) v |= static_cast<unsigned>(data[i + 1]) << 8;
+        if(_left > 2) v |= data[i + 2];
+        _text += _table[v >> 18];
+        _text += _table[(v >> 12) & 63];
+        _text += _left > 1 ? _table[(v >> 6) & 63] : '=';
+        _text += _left > 2 ? _table[v & 63] : '=';
+    }
+    return _text;
+}
+
+//! every size around the 12- and 16-byte vector steps, all byte values
+static void test_codec() {
+    std::mt19937 _rng(3);
+    for(std::size_t _size = 0; _size < 200; _size++) {
+        std::vector<unsigned char> _data(_size);
+        for(auto& _byte : _data) _byte = static_cast<unsigned char>(_rng());
+        std::string _text(param::utils::base64_encoded_size(_size), '?');
+        param::utils::base64_encode(_data.data(), _size, &_text[0]);
+        CHECK(_text == reference(_data));
+        std::vector<char> _decoded{};
+        CHECK(param::utils::base64_decode(_text.data(), _text.size(), _decoded));
+        CHECK(_decoded.size() == _size && (_size == 0 || std::memcmp(_decoded.data(), _data.data(), _size) == 0));
+        // a char outside the alphabet anywhere, inside or after a vector step
+        for(std::size_t i = 0; i < _text.size() && _text[i] != '='; i += 1 + i / 16) {
+            for(char _bad : {'*', '-', '\0', static_cast<char>(0xc3)}) {
+                std::string _broken = _text;
+                _broken[i] = _bad;
+                CHECK(!param::utils::base64_decode(_broken.data(), _broken.size(), _decoded));
+            }
+        }
+    }
+}
+
+static void test_ragged() {
+    {
+        std::ofstream _file("base64.json", std::ios::binary | std::ios::trunc);
+        _file << "{}";
+    }
+    const std::vector<std::vector<double>> _rows{{1.5, -2.0, 3.25}, {}, {4.0}, {0.125, 1e300, -0.0, 7.0, 8.0}};
+    const std::vector<std::vector<int>> _square{{1, 2}, {3, 4}};
+    param::ParaManager _manager{};
+    CHECK(_manager.load("base64.json"));
+    _manager.set_array_format(param::ArrayFormat::Base64);
+    _manager.set("/rows", _rows);
+    _manager.set("/square", _square);
+    CHECK(_manager.get<std::vector<std::vector<double>>>("/rows") == _rows);
+    CHECK(_manager.get<std::vector<std::vector<int>>>("/square") == _square);
+    // no flat or NDArray reading of ragged rows
+    CHECK(_manager.get<std::vector<double>>("/rows", {9.0}) == std::vector<double>({9.0}));
+    CHECK(_manager.get<param::NDArray<double>>("/rows").size() == 0);
+
+    CHECK(_manager.save("base64_out.json", true));
+    const std::string _text = read_file("base64_out.json");
+    CHECK(_text.find(R"("rows":{"$dtype":"f8","$lengths":[3,0,1,5],"$b64":")") != std::string::npos);
+    CHECK(_text.find(R"("square":{"$dtype":"i4","$shape":[2,2],"$b64":")") != std::string::npos);
+    param::ParaManager _reloaded{};
+    CHECK(_reloaded.load("base64_out.json"));
+    CHECK(_reloaded.get<std::vector<std::vector<double>>>("/rows") == _rows);
+    CHECK(_reloaded.get<std::vector<std::vector<float>>>("/rows").size() == _rows.size());
+
+    // row lengths adding up to more than the data
+    {
+        std::ofstream _file("base64_out.json", std::ios::binary | std::ios::trunc);
+        _file << R"({"rows": {"$dtype": "f8", "$lengths": [1, 2], "$b64": "AAAAAAAA+D8="}})";
+    }
+    CHECK(_reloaded.load("base64_out.json"));
+    CHECK(_reloaded.get<std::vector<std::vector<double>>>("/rows").empty());
+    std::remove("base64.json");
+    std::remove("base64_out.json");
+}
+
+int main() {
+    test_codec();
+    test_ragged();
+    return check_result();
+}
@@ -0,0 +1,93 @@
+/**
+ * @file test/test_decimals.cpp
+ * @brief save() with decimal places: doubles rounded half away from zero, not truncated
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mjson.hpp"
+#include "check.hpp"
+
+static std::string read_file(const std::string& path) {
+    std::ifstream _file(path, std::ios::binary);
+    std::stringstream _text{};
+    _text << _file.rdbuf();
+    return _text.str();
+}
+
+//! one double written with `decimals` places through rapidjson's Writer, as save() configures it
+static std::string write(double value, int decimals) {
+    rapidjson::StringBuffer _buffer{};
+    rapidjson::Writer<rapidjson::StringBuffer, rapidjson::UTF8<>, rapidjson::UTF8<>, rapidjson::CrtAllocator,
+                      rapidjson::kWriteDefaultFlags | rapidjson::kWriteRoundDecimalPlacesFlag> _writer(_buffer);
+    _writer.SetMaxDecimalPlaces(decimals);
+    _writer.Double(value);
+    return _buffer.GetString();
+}
+
+static void test_examples() {
+    CHECK(write(0.9999, 2) == "1.0");
+    CHECK(write(-0.9999, 2) == "-1.0");
+    CHECK(write(0.123456, 3) == "0.123");
+    CHECK(write(0.12351, 3) == "0.124");
+    CHECK(write(0.1296, 2) == "0.13");
+    CHECK(write(99.996, 2) == "100.0");
+    CHECK(write(1.05, 1) == "1.1");
+    CHECK(write(2.5, 3) == "2.5");
+    CHECK(write(0.0004, 3) == "0.0");
+    CHECK(write(0.0005, 3) == "0.001");
+    CHECK(write(0.00096, 3) == "0.001");
+    CHECK(write(1.234567890123456e30, 3) == "1.234567890123456e30");
+    CHECK(write(1.23e-7, 8) == "1.2e-7");
+    // without the flag the Writer keeps truncating
+    rapidjson::StringBuffer _buffer{};
+    rapidjson::Writer<rapidjson::StringBuffer> _writer(_buffer);
+    _writer.SetMaxDecimalPlaces(2);
+    _writer.Double(0.9999);
+    CHECK(std::string(_buffer.GetString()) == "0.99");
+}
+
+//! the written value is a multiple of 10^-decimals within half of it from the input
+static void test_random() {
+    std::mt19937_64 _rng(7);
+    std::uniform_real_distribution<double> _uniform(-1000.0, 1000.0);
+    for(int i = 0; i < 200000; i++) {
+        const double _value = _uniform(_rng) / std::pow(10.0, static_cast<double>(i % 4));
+        const int _decimals = 1 + i % 8;
+        const std::string _text = write(_value, _decimals);
+        const double _written = std::strtod(_text.c_str(), nullptr);
+        const double _unit = std::pow(10.0, -_decimals);
+        const double _units = _written / _unit;
+        CHECK(std::abs(_units - std::round(_units)) < 1e-6);
+        CHECK(std::abs(_written - _value) <= _unit * (0.5 + 1e-9));
+    }
+}
+
+static void test_save() {
+    param::ParaManager _manager{};
+    {
+        std::ofstream _file("decimals.json", std::ios::binary | std::ios::trunc);
+        _file << "{}";
+    }
+    CHECK(_manager.load("decimals.json"));
+    _manager.set("/x", 0.9999);
+    _manager.set("/v", std::vector<double>({0.12351, -2.71828, 3.0}));
+    CHECK(_manager.save("decimals_out.json", true, 3));
+    CHECK(read_file("decimals_out.json") == R"({"x":1.0,"v":[0.124,-2.718,3.0]})");
+    CHECK(_manager.save("decimals_out.json", true));
+    CHECK(read_file("decimals_out.json") == R"({"x":0.9999,"v":[0.12351,-2.71828,3.0]})");
+    std::remove("decimals.json");
+    std::remove("decimals_out.json");
+}
+
+int main() {
+    test_examples();
+    test_random();
+    test_save();
+    return check_result();
+}
@@ -0,0 +1,106 @@
+/**
+ * @file test/test_direct.cpp
+ * @brief Direct numeric arrays: flat decoding at the keypath, expansion for every other access
+ */
+
+#include <array>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "mjson.hpp"
+#include "check.hpp"
+
+static void write_file(const std::string& path, const std::string& text) {
+    std::ofstream _file(path, std::ios::binary | std::ios::trunc);
+    _file << text;
+}
+
+static const char* kMatrix = R"({"m": [[1.5, 2.5], [3.5, 4.5]], "v": [1, 2, 3], "s": "text"})";
+
+static void load_direct(param::ParaManager& manager) {
+    write_file("direct.json", kMatrix);
+    manager.set_direct_arrays({"/m", "/v"});
+    CHECK(manager.load("direct.json"));
+    CHECK(!manager.has_parse_error());
+}
+
+//! save and load again without direct arrays, the reference for what the document holds
+static void reload(param::ParaManager& manager, param::ParaManager& plain) {
+    CHECK(manager.save("direct_out.json"));
+    CHECK(plain.load("direct_out.json"));
+    CHECK(!plain.has_parse_error());
+}
+
+static void test_flat_reads() {
+    param::ParaManager _manager{};
+    load_direct(_manager);
+    CHECK(_manager.get<std::vector<std::vector<double>>>("/m") == std::vector<std::vector<double>>({{1.5, 2.5}, {3.5, 4.5}}));
+    CHECK(_manager.get<std::vector<int>>("/v") == std::vector<int>({1, 2, 3}));
+    CHECK(_manager.get<param::NDArray<double>>("/m").shape() == std::vector<std::size_t>({2, 2}));
+    CHECK(_manager.keys() == std::vector<std::string>({"/m", "/v", "/s"}));
+}
+
+static void test_reads_below_and_at() {
+    param::ParaManager _manager{};
+    load_direct(_manager);
+    CHECK(_manager.get<double>("/m/1/1") == 4.5);
+    CHECK((_manager.get<std::array<double, 2>>("/m/0") == std::array<double, 2>{{1.5, 2.5}}));
+    CHECK((_manager.get<std::array<int, 3>>("/v") == std::array<int, 3>{{1, 2, 3}}));
+    CHECK(_manager.get<std::string>("/v") == "[1,2,3]");
+    double _row[2] = {0, 0};
+    CHECK(_manager.get("/m/1", _row) && _row[0] == 3.5 && _row[1] == 4.5);
+    CHECK(_manager.get<std::vector<std::vector<double>>>("/m") == std::vector<std::vector<double>>({{1.5, 2.5}, {3.5, 4.5}}));
+    param::ParaManager _plain{};
+    reload(_manager, _plain);
+    CHECK(_plain.get<std::vector<int>>("/v") == std::vector<int>({1, 2, 3}));
+}
+
+static void test_writes_below() {
+    param::ParaManager _manager{};
+    load_direct(_manager);
+    _manager.set("/m/0/0", 9.0);
+    _manager.set("/v/3", 4);
+    CHECK(_manager.get<double>("/m/0/0") == 9.0);
+    CHECK(_manager.get<std::vector<std::vector<double>>>("/m") == std::vector<std::vector<double>>({{9.0, 2.5}, {3.5, 4.5}}));
+    CHECK(_manager.get<std::vector<int>>("/v") == std::vector<int>({1, 2, 3, 4}));
+    CHECK(_manager.erase("/m/1"));
+    param::ParaManager _plain{};
+    reload(_manager, _plain);
+    CHECK(_plain.get<std::vector<std::vector<double>>>("/m") == std::vector<std::vector<double>>({{9.0, 2.5}}));
+    CHECK(_plain.get<std::vector<int>>("/v") == std::vector<int>({1, 2, 3, 4}));
+    CHECK(_plain.get<std::string>("/s") == "text");
+}
+
+static void test_writes_at() {
+    param::ParaManager _manager{};
+    load_direct(_manager);
+    _manager.set("/m", std::vector<double>({7.0}));
+    CHECK(_manager.erase("/v"));
+    CHECK(_manager.get<std::vector<double>>("/m") == std::vector<double>({7.0}));
+    CHECK(_manager.get<std::vector<int>>("/v").empty());
+    param::ParaManager _plain{};
+    reload(_manager, _plain);
+    CHECK(_plain.get<std::vector<double>>("/m") == std::vector<double>({7.0}));
+    CHECK(!_plain.get<std::vector<int>>("/v", {0}).empty());
+}
+
+static void test_concurrent_expansion() {
+    write_file("direct.json", kMatrix);
+    param::ConcurrentParaManager _manager{};
+    _manager.set_direct_arrays({"/m"});
+    CHECK(_manager.load("direct.json"));
+    CHECK(_manager.get<std::vector<std::vector<double>>>("/m").size() == 2);
+    CHECK(_manager.get<double>("/m/1/0") == 3.5);
+    CHECK(_manager.get<std::string>("/m") == "[[1.5,2.5],[3.5,4.5]]");
+}
+
+int main() {
+    test_flat_reads();
+    test_reads_below_and_at();
+    test_writes_below();
+    test_writes_at();
+    test_concurrent_expansion();
+    std::remove("direct.json");
+    std::remove("direct_out.json");
+    return check_result();
+}
@@ -0,0 +1,72 @@
+/**
+ * @file test/test_lazy.cpp
+ * @brief Lazy load mode: values parsed on demand, failed reloads keep the previous document
+ */
+
+#include <fstream>
+#include <string>
+#include "mjson.hpp"
+#include "check.hpp"
+
+static void write_file(const std::string& path, const std::string& text) {
+    std::ofstream _file(path, std::ios::binary | std::ios::trunc);
+    _file << text;
+}
+
+static std::string wide_object(std::size_t keys) {
+    std::string _text = "{";
+    for(std::size_t i = 0; i < keys; i++) {
+        if(i != 0) _text += ",";
+        _text += "\"k" + std::to_string(i) + "\": {\"s\": \"v" + std::to_string(i) + "\", \"a\": [" + std::to_string(i) + ", [1, 2]]}";
+    }
+    return _text + "}";
+}
+
+//! a reload that fails must leave the tape describing the document that is still loaded
+static void test_failed_reload(std::size_t keys, const std::string& bad) {
+    write_file("lazy_good.json", wide_object(keys));
+    write_file("lazy_bad.json", bad);
+    param::ParaManager _manager{};
+    _manager.set_lazy(true);
+    CHECK(_manager.load("lazy_good.json"));
+    CHECK(_manager.load("lazy_bad.json"));
+    CHECK(_manager.has_parse_error());
+    CHECK(_manager.filename() == "lazy_good.json");
+    CHECK(_manager.get<std::string>("/k1/s") == "v1");
+    CHECK(_manager.get<std::string>("/k" + std::to_string(keys / 2) + "/s") == "v" + std::to_string(keys / 2));
+    CHECK(_manager.get<int>("/k" + std::to_string(keys - 1) + "/a/0") == static_cast<int>(keys - 1));
+    CHECK(_manager.get<std::vector<int>>("/k3/a/1") == std::vector<int>({1, 2}));
+    CHECK(_manager.keys().size() >= keys);
+    CHECK(_manager.save("lazy_out.json"));
+    param::ParaManager _eager{};
+    CHECK(_eager.load("lazy_out.json"));
+    CHECK(!_eager.has_parse_error());
+    CHECK(_eager.get<std::string>("/k" + std::to_string(keys - 1) + "/s") == "v" + std::to_string(keys - 1));
+    std::remove("lazy_good.json");
+    std::remove("lazy_bad.json");
+    std::remove("lazy_out.json");
+}
+
+static void test_reload_replaces_tape() {
+    write_file("lazy_a.json", R"({"x": {"y": [1, 2, 3]}, "z": "first"})");
+    write_file("lazy_b.json", R"(  {"z": "second", "x": {"y": [4, {"w": 5}]}})");
+    param::ParaManager _manager{};
+    _manager.set_lazy(true);
+    CHECK(_manager.load("lazy_a.json"));
+    CHECK(_manager.get<int>("/x/y/2") == 3);
+    CHECK(_manager.load("lazy_b.json"));
+    CHECK(!_manager.has_parse_error());
+    CHECK(_manager.get<int>("/x/y/1/w") == 5);
+    CHECK(_manager.get<std::string>("/z") == "second");
+    std::remove("lazy_a.json");
+    std::remove("lazy_b.json");
+}
+
+int main() {
+    test_failed_reload(10, R"({"a":)");
+    test_failed_reload(1500, R"({"a":)");
+    test_failed_reload(1500, R"({"a": [1, 2}})");
+    test_failed_reload(1500, R"({"a": 1}})");
+    test_reload_replaces_tape();
+    return check_result();
+}
@@ -0,0 +1,139 @@
+/**
+ * @file test/test_member_index.cpp
+ * @brief Member hash index of wide objects: random edits checked against a plain member list
+ */
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "rapidjson/document.h"
+#include "check.hpp"
+
+using Value = rapidjson::Value;
+using Allocator = rapidjson::Document::AllocatorType;
+
+//! the object must hold exactly these names in this order, value i being the number in its name
+static bool same(const Value& object, const std::vector<int>& names) {
+    if(object.MemberCount() != names.size()) return false;
+    Value::ConstMemberIterator _itr = object.MemberBegin();
+    for(int _name : names) {
+        if(_itr->name.GetString() != "k" + std::to_string(_name) || _itr->value.GetInt() != _name) return false;
+        ++_itr;
+    }
+    return true;
+}
+
+//! every present name is found at its position, every absent one is not found
+static bool lookups(const Value& object, const std::vector<int>& names, int universe) {
+    for(int _name = 0; _name < universe; ++_name) {
+        const std::string _key = "k" + std::to_string(_name);
+        Value::ConstMemberIterator _found = object.FindMember(_key.c_str());
+        const auto _pos = std::find(names.begin(), names.end(), _name);
+        if(_pos == names.end()) {
+            if(_found != object.MemberEnd()) return false;
+        } else if(_found == object.MemberEnd() || _found - object.MemberBegin() != _pos - names.begin()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void add(Value& object, std::vector<int>& names, int name, Allocator& allocator) {
+    Value _key(("k" + std::to_string(name)).c_str(), allocator);
+    Value _value(name);
+    object.AddMember(_key, _value, allocator);
+    names.push_back(name);
+}
+
+static void test_random_edits(unsigned seed, bool lookup_between) {
+    std::mt19937 _random(seed);
+    rapidjson::Document _document{};
+    Allocator& _allocator = _document.GetAllocator();
+    Value _object(rapidjson::kObjectType);
+    std::vector<int> _names{};
+    std::vector<int> _absent{};
+    const int _universe = 200;
+    for(int _name = 0; _name < _universe; ++_name) _absent.push_back(_name);
+    std::shuffle(_absent.begin(), _absent.end(), _random);
+
+    for(int _step = 0; _step < 3000; ++_step) {
+        // grow for 300 steps, shrink for 300, so objects cross the index threshold both ways
+        const bool _growing = _step % 600 < 300;
+        const unsigned _op = _random() % 10;
+        if((_op < (_growing ? 7u : 2u) || _names.empty()) && !_absent.empty()) {
+            add(_object, _names, _absent.back(), _allocator);
+            _absent.pop_back();
+        } else if(_op < 8 && _random() % 3 == 0 && !_names.empty()) {
+            // RemoveMember moves the last member into the hole
+            const std::size_t _pos = _random() % _names.size();
+            const std::string _key = "k" + std::to_string(_names[_pos]);
+            CHECK(_object.RemoveMember(_key.c_str()));
+            _absent.push_back(_names[_pos]);
+            _names[_pos] = _names.back();
+            _names.pop_back();
+        } else if(_op < 8 && !_names.empty()) {
+            const std::size_t _pos = _random() % _names.size();
+            const std::string _key = "k" + std::to_string(_names[_pos]);
+            CHECK(_object.EraseMember(_key.c_str()));
+            _absent.push_back(_names[_pos]);
+            _names.erase(_names.begin() + static_cast<std::ptrdiff_t>(_pos));
+        } else if(_op < 9 && !_names.empty()) {
+            const std::size_t _first = _random() % _names.size();
+            const std::size_t _last = _first + _random() % (std::min<std::size_t>(_names.size() - _first, 8) + 1);
+            _object.EraseMember(_object.MemberBegin() + static_cast<std::ptrdiff_t>(_first), _object.MemberBegin() + static_cast<std::ptrdiff_t>(_last));
+            _absent.insert(_absent.end(), _names.begin() + static_cast<std::ptrdiff_t>(_first), _names.begin() + static_cast<std::ptrdiff_t>(_last));
+            _names.erase(_names.begin() + static_cast<std::ptrdiff_t>(_first), _names.begin() + static_cast<std::ptrdiff_t>(_last));
+        } else {
+            Value _copy(_object, _allocator);
+            CHECK(same(_copy, _names));
+            CHECK(lookups(_copy, _names, _universe));
+            _object.Swap(_copy);
+        }
+        if(lookup_between || _step % 97 == 0) {
+            CHECK(same(_object, _names));
+            CHECK(lookups(_object, _names, _universe));
+        }
+        std::shuffle(_absent.begin(), _absent.end(), _random);
+    }
+    CHECK(same(_object, _names));
+    CHECK(lookups(_object, _names, _universe));
+    _object.RemoveAllMembers();
+    _names.clear();
+    add(_object, _names, 7, _allocator);
+    CHECK(lookups(_object, _names, _universe));
+}
+
+static void test_parsed_object() {
+    std::string _text = "{";
+    for(int _name = 0; _name < 100; ++_name) _text += (_name ? ",\"k" : "\"k") + std::to_string(_name) + "\":" + std::to_string(_name);
+    _text += "}";
+    rapidjson::Document _document{};
+    _document.Parse(_text.c_str());
+    CHECK(!_document.HasParseError());
+    std::vector<int> _names{};
+    for(int _name = 0; _name < 100; ++_name) _names.push_back(_name);
+    CHECK(lookups(_document, _names, 120));
+
+    // concurrent const lookups on an object whose table is not built yet
+    rapidjson::Document _fresh{};
+    _fresh.Parse(_text.c_str());
+    const Value& _shared = _fresh;
+    std::vector<std::thread> _readers{};
+    std::vector<int> _ok(4, 0);
+    for(int _reader = 0; _reader < 4; ++_reader) {
+        _readers.emplace_back([&_shared, &_names, &_ok, _reader] { _ok[_reader] = lookups(_shared, _names, 120); });
+    }
+    for(std::thread& _reader : _readers) _reader.join();
+    CHECK(std::count(_ok.begin(), _ok.end(), 1) == 4);
+}
+
+int main() {
+    for(unsigned _seed = 1; _seed <= 4; ++_seed) {
+        test_random_edits(_seed, true);
+        test_random_edits(_seed, false);
+    }
+    test_parsed_object();
+    return check_result();
+}
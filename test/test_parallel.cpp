@@ -0,0 +1,120 @@
+/**
+ * @file test/test_parallel.cpp
+ * @brief Parallel load: the stitched document saves exactly like the serial parse of the same file
+ */
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mjson.hpp"
+#include "check.hpp"
+
+static void write_file(const std::string& path, const std::string& text) {
+    std::ofstream _file(path, std::ios::binary | std::ios::trunc);
+    _file << text;
+}
+
+static std::string read_file(const std::string& path) {
+    std::ifstream _file(path, std::ios::binary);
+    std::stringstream _text{};
+    _text << _file.rdbuf();
+    return _text.str();
+}
+
+//! strings holding quotes, escapes and brackets, so that a wrong scan cuts inside them
+static std::string tricky(std::size_t i) {
+    static const char* kStrings[] = {R"(plain)", R"(a \"quoted\" {word}, [x])", R"(back\\slash\\)", R"(\\\"}], {[)", R"(é\n\t)", R"()"};
+    return "\"" + std::string(kStrings[i % 6]) + "\"";
+}
+
+//! root object with a large array of records, a large nested object and small members around them
+static std::string large_object(std::size_t records) {
+    std::string _text = "{\"head\": " + tricky(1) + ", \"records\": [";
+    for(std::size_t i = 0; i < records; i++) {
+        if(i != 0) _text += ",\n ";
+        _text += "{\"id\": " + std::to_string(i) + ", " + tricky(i) + ": " + tricky(i + 1) + ", \"v\": [" + std::to_string(i * 0.25) +
+                 ", -1e-3, {}, [], null, true]}";
+    }
+    _text += "], \"index\": {";
+    for(std::size_t i = 0; i < records; i++) {
+        if(i != 0) _text += ", ";
+        _text += "\"k" + std::to_string(i) + "\\\"}\": [" + std::to_string(i) + ", " + tricky(i) + "]";
+    }
+    return _text + "}, \"tail\": [1, 2, 3]}";
+}
+
+//! root array of large arrays
+static std::string large_array(std::size_t rows) {
+    std::string _text = "[";
+    for(std::size_t r = 0; r < 3; r++) {
+        _text += r ? ", [" : "[";
+        for(std::size_t i = 0; i < rows; i++) _text += (i ? ", " : "") + std::to_string(r * rows + i) + (i % 7 ? "" : ", " + tricky(i));
+        _text += "]";
+    }
+    return _text + "]";
+}
+
+static void check_same(const std::string& text, param::ParaManager& parallel) {
+    write_file("parallel.json", text);
+    param::ParaManager _serial{};
+    CHECK(_serial.load("parallel.json"));
+    CHECK(!_serial.has_parse_error());
+    CHECK(parallel.load("parallel.json"));
+    CHECK(!parallel.has_parse_error());
+    CHECK(_serial.save("parallel_serial.json", true));
+    CHECK(parallel.save("parallel_stitched.json", true));
+    const std::string _expected = read_file("parallel_serial.json");
+    CHECK(!_expected.empty());
+    CHECK(read_file("parallel_stitched.json") == _expected);
+    std::remove("parallel.json");
+    std::remove("parallel_serial.json");
+    std::remove("parallel_stitched.json");
+}
+
+static void test_same_as_serial() {
+    for(std::size_t threads : {2, 3, 8}) {
+        param::ParaManager _parallel{};
+        _parallel.set_parallel(threads, 0);
+        check_same(large_object(20000), _parallel);
+        check_same(large_array(60000), _parallel);
+        check_same(R"({"small": [1, 2]})", _parallel);
+    }
+}
+
+//! the user buffer and retained chunks serve a parallel load, repeated reloads keep giving the same document
+static void test_pool_options() {
+    std::vector<char> _buffer(1 << 20);
+    param::PoolOptions _options{};
+    _options.buffer = _buffer.data();
+    _options.buffer_size = _buffer.size();
+    _options.retain = true;
+    param::ParaManager _parallel{};
+    _parallel.set_pool_options(_options);
+    _parallel.set_parallel(4, 0);
+    for(int i = 0; i < 4; i++) check_same(large_object(10000 + 3000 * (i % 2)), _parallel);
+    for(int i = 0; i < 3; i++) check_same(large_array(30000), _parallel);
+}
+
+static void test_parse_error() {
+    std::string _bad = large_object(5000);
+    _bad.insert(_bad.size() / 2, "}");
+    write_file("parallel_good.json", large_array(1000));
+    write_file("parallel_bad.json", _bad);
+    param::ParaManager _parallel{};
+    _parallel.set_parallel(4, 0);
+    CHECK(_parallel.load("parallel_good.json"));
+    CHECK(_parallel.load("parallel_bad.json"));
+    CHECK(_parallel.has_parse_error());
+    CHECK(_parallel.filename() == "parallel_good.json");
+    CHECK(_parallel.get<int>("/2/0") == 2000);
+    std::remove("parallel_good.json");
+    std::remove("parallel_bad.json");
+}
+
+int main() {
+    test_same_as_serial();
+    test_pool_options();
+    test_parse_error();
+    return check_result();
+}
@@ -0,0 +1,169 @@
+/**
+ * @file test/test_pools.cpp
+ * @brief Document pools: retained chunks and user buffers across reloads, move-assignment and layers
+ * @details Meant to run under AddressSanitizer (-DMJSON_BUILD_ASAN=ON), which reports any value left
+ * pointing into a recycled chunk or into a user buffer the manager no longer owns.
+ */
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "mjson.hpp"
+#include "check.hpp"
+
+static void write_file(const std::string& path, const std::string& text) {
+    std::ofstream _file(path, std::ios::binary | std::ios::trunc);
+    _file << text;
+}
+
+//! `count` members "k<i>": {"s": "<tag> <i> ...", "a": [i, i + 1]}, strings too long for inline storage
+static std::string document(const std::string& tag, std::size_t count) {
+    std::string _text = "{\"tag\": \"" + tag + "\"";
+    for(std::size_t i = 0; i < count; i++) {
+        _text += ", \"k" + std::to_string(i) + "\": {\"s\": \"" + tag + " " + std::to_string(i) + " padding the string past the short form\", \"a\": [" +
+                 std::to_string(i) + ", " + std::to_string(i + 1) + "]}";
+    }
+    return _text + "}";
+}
+
+static bool holds(param::ParaManager& manager, const std::string& tag, std::size_t count) {
+    if(manager.get<std::string>("/tag") != tag) return false;
+    for(std::size_t i = 0; i < count; i += 1 + count / 50) {
+        const std::string _key = "/k" + std::to_string(i);
+        if(manager.get<std::string>(_key + "/s") != tag + " " + std::to_string(i) + " padding the string past the short form") return false;
+        if(manager.get<std::vector<int>>(_key + "/a") != std::vector<int>({static_cast<int>(i), static_cast<int>(i + 1)})) return false;
+    }
+    return true;
+}
+
+static param::PoolOptions options(std::vector<char>& buffer, bool retain) {
+    param::PoolOptions _options{};
+    _options.chunk_size = 4096;
+    _options.buffer = buffer.data();
+    _options.buffer_size = buffer.size();
+    _options.retain = retain;
+    return _options;
+}
+
+//! reloads alternate between the buffer halves and retained chunks of two sizes, failed parses in between
+static void test_reload() {
+    write_file("pools_small.json", document("small", 20));
+    write_file("pools_large.json", document("large", 3000));
+    write_file("pools_bad.json", document("bad", 500) + "}");
+    for(bool _retain : {false, true}) {
+        std::vector<char> _buffer(64 * 1024);
+        param::ParaManager _manager{};
+        _manager.set_pool_options(options(_buffer, _retain));
+        for(int i = 0; i < 6; i++) {
+            const bool _large = i % 3 != 0;
+            CHECK(_manager.load(_large ? "pools_large.json" : "pools_small.json"));
+            CHECK(!_manager.has_parse_error());
+            CHECK(_manager.load("pools_bad.json"));
+            CHECK(_manager.has_parse_error());
+            CHECK(holds(_manager, _large ? "large" : "small", _large ? 3000 : 20));
+            _manager.set("/k1/s", std::string(200, 'x'));
+            CHECK(_manager.get<std::string>("/k1/s") == std::string(200, 'x'));
+        }
+    }
+}
+
+//! options changed between loads: the old buffer is released by the load that follows
+static void test_new_buffer() {
+    auto _old = std::make_unique<std::vector<char>>(64 * 1024);
+    std::vector<char> _new(32 * 1024);
+    param::ParaManager _manager{};
+    _manager.set_pool_options(options(*_old, true));
+    CHECK(_manager.load("pools_small.json"));
+    CHECK(_manager.load("pools_large.json"));
+    _manager.set_pool_options(options(_new, true));
+    CHECK(holds(_manager, "large", 3000));
+    CHECK(_manager.load("pools_small.json"));
+    _old.reset();
+    CHECK(holds(_manager, "small", 20));
+    for(int i = 0; i < 3; i++) {
+        CHECK(_manager.load(i % 2 ? "pools_small.json" : "pools_large.json"));
+        CHECK(holds(_manager, i % 2 ? "small" : "large", i % 2 ? 20 : 3000));
+    }
+}
+
+//! the pool of a replaced document may serve the target's next load, never the source's buffer
+static void test_move_assign() {
+    auto _first = std::make_unique<std::vector<char>>(64 * 1024);
+    std::vector<char> _second(64 * 1024);
+    param::ParaManager _target{};
+    param::ParaManager _source{};
+    _target.set_pool_options(options(*_first, true));
+    _source.set_pool_options(options(_second, true));
+    CHECK(_target.load("pools_large.json"));
+    CHECK(_target.load("pools_small.json"));
+    CHECK(_source.load("pools_large.json"));
+    _target = std::move(_source);
+    // the target now lives in the source's pools and no longer refers to its own buffer
+    _first.reset();
+    CHECK(holds(_target, "large", 3000));
+    for(int i = 0; i < 4; i++) {
+        CHECK(_target.load(i % 2 ? "pools_large.json" : "pools_small.json"));
+        CHECK(holds(_target, i % 2 ? "large" : "small", i % 2 ? 3000 : 20));
+    }
+    // the moved-from manager starts over
+    CHECK(_source.load("pools_small.json"));
+    CHECK(holds(_source, "small", 20));
+
+    // a plain manager moved into one with options
+    std::vector<char> _third(64 * 1024);
+    param::ParaManager _plain{};
+    CHECK(_plain.load("pools_small.json"));
+    _target.set_pool_options(options(_third, true));
+    CHECK(_target.load("pools_large.json"));
+    _target = std::move(_plain);
+    CHECK(holds(_target, "small", 20));
+    CHECK(_target.load("pools_large.json"));
+    CHECK(holds(_target, "large", 3000));
+}
+
+//! load_layers() moves the top layer into the manager, with the pools it inherited from it
+static void test_layers() {
+    write_file("pools_override.json", R"({"tag": "override", "extra": "only in the top layer, long enough to be allocated"})");
+    std::vector<char> _buffer(64 * 1024);
+    param::ParaManager _manager{};
+    _manager.set_pool_options(options(_buffer, true));
+    CHECK(_manager.load("pools_small.json"));
+    for(int i = 0; i < 4; i++) {
+        CHECK(_manager.load_layers({"pools_large.json", "pools_override.json"}));
+        CHECK(!_manager.has_parse_error());
+        CHECK(_manager.get<std::string>("/tag") == "override");
+        CHECK(_manager.get<std::string>("/extra") == "only in the top layer, long enough to be allocated");
+        CHECK(_manager.get<std::vector<int>>("/k2999/a") == std::vector<int>({2999, 3000}));
+        CHECK(_manager.load_layers({"pools_small.json", "pools_bad.json"}));
+        CHECK(_manager.has_parse_error());
+        CHECK(_manager.get<std::string>("/tag") == "override");
+        CHECK(_manager.load(i % 2 ? "pools_large.json" : "pools_small.json"));
+        CHECK(holds(_manager, i % 2 ? "large" : "small", i % 2 ? 3000 : 20));
+    }
+}
+
+static void test_concurrent_reload() {
+    std::vector<char> _buffer(64 * 1024);
+    param::ConcurrentParaManager _manager{};
+    _manager.set_pool_options(options(_buffer, true));
+    for(int i = 0; i < 6; i++) {
+        const bool _large = i % 2 == 0;
+        CHECK(_manager.load(_large ? "pools_large.json" : "pools_small.json"));
+        CHECK(_manager.get<std::string>("/tag") == (_large ? "large" : "small"));
+        CHECK(_manager.get<std::string>("/k7/s") == std::string(_large ? "large" : "small") + " 7 padding the string past the short form");
+    }
+}
+
+int main() {
+    test_reload();
+    test_new_buffer();
+    test_move_assign();
+    test_layers();
+    test_concurrent_reload();
+    std::remove("pools_small.json");
+    std::remove("pools_large.json");
+    std::remove("pools_bad.json");
+    std::remove("pools_override.json");
+    return check_result();
+}
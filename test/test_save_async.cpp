@@ -0,0 +1,97 @@
+/**
+ * @file test/test_save_async.cpp
+ * @brief save_async(): snapshot isolation, coalescing, callbacks and the saved state
+ */
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mjson.hpp"
+#include "check.hpp"
+
+static int read_n(const std::string& path) {
+    param::ParaManager _manager{};
+    if(!_manager.load(path) || _manager.has_parse_error()) return -1;
+    return _manager.get<int>("/n", -1);
+}
+
+//! what was set before save_async() is written, what was set after is not
+static void test_snapshot_isolation() {
+    param::ParaManager _manager{};
+    std::vector<std::vector<double>> _big(500, std::vector<double>(500, 0.5));
+    _manager.set("/big", _big);
+    _manager.set("/n", 1);
+    auto _future = _manager.save_async("async_a.json");
+    _manager.set("/n", 2);
+    _manager.set("/big/0/0", 9.0);
+    CHECK(_manager.erase("/big/1"));
+    CHECK(_future.get());
+    param::ParaManager _saved{};
+    CHECK(_saved.load("async_a.json"));
+    CHECK(_saved.get<int>("/n") == 1);
+    CHECK(_saved.get<std::vector<std::vector<double>>>("/big") == _big);
+    CHECK(_manager.dirty());
+    CHECK(_manager.get<int>("/n") == 2);
+    std::remove("async_a.json");
+}
+
+static void test_coalescing_and_callbacks() {
+    param::ParaManager _manager{};
+    std::vector<std::vector<double>> _big(300, std::vector<double>(300, 0.25));
+    _manager.set("/big", _big);
+    std::atomic<int> _calls{0};
+    std::vector<std::shared_future<bool>> _futures{};
+    for(int i = 0; i < 20; i++) {
+        _manager.set("/n", i);
+        _futures.push_back(_manager.save_async("async_b.json", true, 0, [&](bool ok) { CHECK(ok); _calls++; }));
+    }
+    for(auto& future : _futures) CHECK(future.get());
+    _manager.save_async("async_c.json").get();
+    CHECK(_calls == 20);
+    CHECK(read_n("async_b.json") == 19);
+    CHECK(!_manager.dirty());
+
+    // nothing to write: ready on return, the callback already ran on this thread
+    auto _caller = std::this_thread::get_id();
+    bool _same_thread = false;
+    auto _clean = _manager.save_async("async_c.json", false, 0, [&](bool ok) { _same_thread = ok && std::this_thread::get_id() == _caller; });
+    CHECK(_clean.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    CHECK(_same_thread);
+    param::ParaManager _empty{};
+    CHECK(!_empty.save_async().get());
+    std::remove("async_b.json");
+    std::remove("async_c.json");
+}
+
+//! the manager goes away, or loads another file, while its snapshot is still being taken or written
+static void test_lifetime() {
+    std::vector<std::vector<double>> _big(400, std::vector<double>(400, 0.75));
+    std::shared_future<bool> _future{};
+    {
+        param::ParaManager _manager{};
+        _manager.set("/big", _big);
+        _manager.set("/n", 3);
+        _future = _manager.save_async("async_d.json");
+    }
+    CHECK(_future.get());
+    CHECK(read_n("async_d.json") == 3);
+
+    param::ParaManager _manager{};
+    _manager.set("/big", _big);
+    _manager.set("/n", 4);
+    auto _pending = _manager.save_async("async_e.json");
+    CHECK(_manager.load("async_d.json"));
+    CHECK(_pending.get());
+    CHECK(read_n("async_e.json") == 4);
+    CHECK(_manager.get<int>("/n") == 3);
+    std::remove("async_d.json");
+    std::remove("async_e.json");
+}
+
+int main() {
+    test_snapshot_isolation();
+    test_coalescing_and_callbacks();
+    test_lifetime();
+    return check_result();
+}
@@ -0,0 +1,120 @@
+/**
+ * @file test/test_watch.cpp
+ * @brief ConcurrentParaManager::watch: outside changes reload, own saves and unsaved changes do not
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+#include "mjson.hpp"
+#include "check.hpp"
+
+#ifdef __linux__
+static void write_file(const std::string& path, const std::string& text) {
+    std::ofstream _file(path, std::ios::binary | std::ios::trunc);
+    _file << text;
+}
+
+//! replace the file the way editors do, through a rename
+static void replace_file(const std::string& path, const std::string& text) {
+    write_file(path + ".new", text);
+    std::rename((path + ".new").c_str(), path.c_str());
+}
+
+template<class F> static bool wait_for(F&& condition) {
+    for(int i = 0; i < 300 && !condition(); i++) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return condition();
+}
+
+static void settle() { std::this_thread::sleep_for(std::chrono::milliseconds(200)); }
+
+struct Events {
+    std::atomic<int> reloaded{0};
+    std::atomic<int> kept{0};
+    std::function<void(bool)> callback() {
+        return [this](bool reloaded) { (reloaded ? this->reloaded : this->kept)++; };
+    }
+};
+
+static void test_own_saves_are_ignored() {
+    write_file("watch_own.json", R"({"v": 0})");
+    param::ConcurrentParaManager _manager{};
+    Events _events{};
+    CHECK(_manager.load("watch_own.json"));
+    CHECK(_manager.watch(_events.callback()));
+    _manager.set("/v", 1);
+    CHECK(_manager.save());
+    for(int i = 0; i < 2000; i++) _manager.set("/n", i);
+    settle();
+    CHECK(_manager.get<int>("/n", -1) == 1999);
+    _manager.set("/v", 2);
+    CHECK(_manager.save_async().get());
+    _manager.set("/w", 3);
+    settle();
+    CHECK(_manager.get<int>("/w", -1) == 3);
+    CHECK(_events.reloaded == 0);
+    CHECK(_events.kept == 0);
+
+    // an outside change after the own save still reloads once the document is clean again
+    CHECK(_manager.save());
+    replace_file("watch_own.json", R"({"v": 7})");
+    CHECK(wait_for([&]() { return _events.reloaded == 1; }));
+    CHECK(_manager.get<int>("/v") == 7);
+    _manager.unwatch();
+    std::remove("watch_own.json");
+}
+
+static void test_unsaved_changes_are_kept() {
+    write_file("watch_dirty.json", R"({"v": 0})");
+    param::ConcurrentParaManager _manager{};
+    Events _events{};
+    CHECK(_manager.load("watch_dirty.json"));
+    CHECK(_manager.watch(_events.callback()));
+    _manager.set("/v", 1);
+    write_file("watch_dirty.json", R"({"v": 5})");
+    CHECK(wait_for([&]() { return _events.kept >= 1; }));
+    CHECK(_events.reloaded == 0);
+    CHECK(_manager.get<int>("/v") == 1);
+    CHECK(_manager.dirty());
+    _manager.unwatch();
+    std::remove("watch_dirty.json");
+}
+
+static void test_follows_load() {
+    ::mkdir("watch_dir", 0755);
+    write_file("watch_first.json", R"({"v": 1})");
+    write_file("watch_dir/second.json", R"({"v": 2})");
+    param::ConcurrentParaManager _manager{};
+    Events _events{};
+    CHECK(_manager.load("watch_first.json"));
+    CHECK(_manager.watch(_events.callback()));
+    CHECK(_manager.load("watch_dir/second.json"));
+    settle();
+    replace_file("watch_first.json", R"({"v": 10})");
+    settle();
+    CHECK(_events.reloaded == 0);
+    CHECK(_manager.get<int>("/v") == 2);
+    replace_file("watch_dir/second.json", R"({"v": 20})");
+    CHECK(wait_for([&]() { return _events.reloaded == 1; }));
+    CHECK(_manager.get<int>("/v") == 20);
+    CHECK(_manager.filename() == "watch_dir/second.json");
+    _manager.unwatch();
+    std::remove("watch_first.json");
+    std::remove("watch_dir/second.json");
+    ::rmdir("watch_dir");
+}
+
+#endif //__linux__
+
+int main() {
+#ifdef __linux__
+    test_own_saves_are_ignored();
+    test_unsaved_changes_are_kept();
+    test_follows_load();
+#endif //__linux__
+    return check_result();
+}
@@ -1,13 +1,42 @@
 import json
+import os
 import numpy as np
 
 
-def numpy2json(data, jsonfile):
+def _npy_dtype(array):
+    if np.iscomplexobj(array):
+        return np.complex64 if array.dtype == np.complex64 else np.complex128
+    if np.issubdtype(array.dtype, np.floating):
+        return np.float32 if array.dtype == np.float32 else np.float64
+    if np.issubdtype(array.dtype, np.integer):
+        return np.int32 if array.dtype.itemsize < 4 or array.dtype == np.int32 else np.int64
+    return None
+
+
+def _sidecar_token(key):
+    # the keypath token of key, escaped like ParaManager so that no two keys share a sidecar
+    token = key.replace('~', '~0').replace('/', '~1')
+    return token.replace('%', '%25').replace('.', '%2E')
+
+
+def numpy2json(data, jsonfile, npy_threshold=0):
+    """
+    Dump a dict of parameters into jsonfile. With npy_threshold > 0, numeric ndarrays
+    holding at least that many elements are saved as "<stem>.<key>.npy" next to jsonfile
+    and referenced by {"$npy": file, "shape": [...], "dtype": "f8"}, as ParaManager does.
+    """
     assert type(data) == dict
+    folder, stem = os.path.split(os.path.splitext(jsonfile)[0])
     for k in data.keys():
         if type(data[k]) != list:
             if type(data[k]) == np.ndarray:
+                dtype = _npy_dtype(data[k])
+                if npy_threshold > 0 and dtype is not None and data[k].size >= npy_threshold:
+                    array = np.ascontiguousarray(data[k], dtype=dtype)
+                    name = '{}.{}.npy'.format(stem, _sidecar_token(k))
+                    np.save(os.path.join(folder, name), array)
+                    data[k] = {'$npy': name, 'shape': list(array.shape), 'dtype': array.dtype.str[1:]}
+                else:
                     data[k] = data[k].tolist()
     with open(jsonfile, 'w') as f:
-        str = json.dump(data, f, indent=4)
-
+        json.dump(data, f, indent=4)